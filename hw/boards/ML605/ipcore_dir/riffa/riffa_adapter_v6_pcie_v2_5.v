@@ -63,7 +63,9 @@ module pcie_app_v6 #(
 	parameter DQ_WIDTH = 64,
 	parameter C_DATA_WIDTH = 9'd64,
 	parameter KEEP_WIDTH = (C_DATA_WIDTH/8),
-	parameter C_NUM_CHNL = 4'd1, 			// Number of RIFFA channels (set as needed: 1-12)
+	parameter INSTR_CHNL = 4'd0,			// RIFFA channel receiving SoftMC instructions
+	parameter RDBACK_CHNL = 4'd1,			// RIFFA channel sending read back data (set to INSTR_CHNL to share one channel)
+	parameter C_NUM_CHNL = (INSTR_CHNL > RDBACK_CHNL ? INSTR_CHNL : RDBACK_CHNL) + 4'd1, // Number of RIFFA channels (set as needed: 1-12)
 	parameter C_MAX_READ_REQ_BYTES = 512,	// Max size of read requests (in bytes). Setting this higher than PCIe Endpoint's MAX READ value just wastes resources
 	parameter C_TAG_WIDTH = 5 				// Number of outstanding tag requests
 )
@@ -432,30 +434,33 @@ generate
 	end
 endgenerate*/
 
+// Instructions arrive on INSTR_CHNL and read back data leaves on RDBACK_CHNL.
+// Using separate channels lets the host stream instructions and drain read 
+// back data from different threads at the same time.
 softMC_pcie_app #(.C_PCI_DATA_WIDTH(C_DATA_WIDTH), .DQ_WIDTH(DQ_WIDTH)
 ) i_soft_pcie(
 	.clk(app_clk),
 	.rst(riffa_reset),
 	
-	.CHNL_RX_CLK(chnl_rx_clk), 
-	.CHNL_RX(chnl_rx), 
-	.CHNL_RX_ACK(chnl_rx_ack), 
-	.CHNL_RX_LAST(chnl_rx_last), 
-	.CHNL_RX_LEN(chnl_rx_len[0 +:32]), 
-	.CHNL_RX_OFF(chnl_rx_off[0 +:31]), 
-	.CHNL_RX_DATA(chnl_rx_data[0 +:C_DATA_WIDTH]), 
-	.CHNL_RX_DATA_VALID(chnl_rx_data_valid), 
-	.CHNL_RX_DATA_REN(chnl_rx_data_ren),
+	.CHNL_RX_CLK(chnl_rx_clk[INSTR_CHNL]), 
+	.CHNL_RX(chnl_rx[INSTR_CHNL]), 
+	.CHNL_RX_ACK(chnl_rx_ack[INSTR_CHNL]), 
+	.CHNL_RX_LAST(chnl_rx_last[INSTR_CHNL]), 
+	.CHNL_RX_LEN(chnl_rx_len[32*INSTR_CHNL +:32]), 
+	.CHNL_RX_OFF(chnl_rx_off[31*INSTR_CHNL +:31]), 
+	.CHNL_RX_DATA(chnl_rx_data[C_DATA_WIDTH*INSTR_CHNL +:C_DATA_WIDTH]), 
+	.CHNL_RX_DATA_VALID(chnl_rx_data_valid[INSTR_CHNL]), 
+	.CHNL_RX_DATA_REN(chnl_rx_data_ren[INSTR_CHNL]),
 	// Tx interface
-	.CHNL_TX_CLK(chnl_tx_clk), 
-	.CHNL_TX(chnl_tx), 
-	.CHNL_TX_ACK(chnl_tx_ack), 
-	.CHNL_TX_LAST(chnl_tx_last), 
-	.CHNL_TX_LEN(chnl_tx_len[0 +:32]), 
-	.CHNL_TX_OFF(chnl_tx_off[0 +:31]), 
-	.CHNL_TX_DATA(chnl_tx_data[0 +:C_DATA_WIDTH]), 
-	.CHNL_TX_DATA_VALID(chnl_tx_data_valid), 
-	.CHNL_TX_DATA_REN(chnl_tx_data_ren),
+	.CHNL_TX_CLK(chnl_tx_clk[RDBACK_CHNL]), 
+	.CHNL_TX(chnl_tx[RDBACK_CHNL]), 
+	.CHNL_TX_ACK(chnl_tx_ack[RDBACK_CHNL]), 
+	.CHNL_TX_LAST(chnl_tx_last[RDBACK_CHNL]), 
+	.CHNL_TX_LEN(chnl_tx_len[32*RDBACK_CHNL +:32]), 
+	.CHNL_TX_OFF(chnl_tx_off[31*RDBACK_CHNL +:31]), 
+	.CHNL_TX_DATA(chnl_tx_data[C_DATA_WIDTH*RDBACK_CHNL +:C_DATA_WIDTH]), 
+	.CHNL_TX_DATA_VALID(chnl_tx_data_valid[RDBACK_CHNL]), 
+	.CHNL_TX_DATA_REN(chnl_tx_data_ren[RDBACK_CHNL]),
 	
 	
 	.app_en(app_en),
@@ -468,6 +473,27 @@ softMC_pcie_app #(.C_PCI_DATA_WIDTH(C_DATA_WIDTH), .DQ_WIDTH(DQ_WIDTH)
 	.rdback_data(rdback_data)
  );
 
+// Tie off the unused direction of each channel
+genvar c;
+generate
+	for (c = 0; c < C_NUM_CHNL; c = c + 1) begin : unused_chnls
+		if (c != INSTR_CHNL) begin
+			assign chnl_rx_clk[c] = app_clk;
+			assign chnl_rx_ack[c] = 1'b0;
+			assign chnl_rx_data_ren[c] = 1'b0;
+		end
+		if (c != RDBACK_CHNL) begin
+			assign chnl_tx_clk[c] = app_clk;
+			assign chnl_tx[c] = 1'b0;
+			assign chnl_tx_last[c] = 1'b1;
+			assign chnl_tx_len[32*c +:32] = 32'd0;
+			assign chnl_tx_off[31*c +:31] = 31'd0;
+			assign chnl_tx_data[C_DATA_WIDTH*c +:C_DATA_WIDTH] = {C_DATA_WIDTH{1'b0}};
+			assign chnl_tx_data_valid[c] = 1'b0;
+		end
+	end
+endgenerate
+
 ////////////////////////////////////
 // END USER CODE
 ////////////////////////////////////
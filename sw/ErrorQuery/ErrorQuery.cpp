@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <iostream>
+#include <sys/stat.h>
+#include "errlog.h"
+#include "patterns.h"
+
+using namespace std;
+
+void printHelp(char* argv[]){
+	cout << "Queries the binary error logs written by the SoftMC tests" << endl;
+	cout << "Usage:" << argv[0] << " LOG BANK ROW_BEGIN ROW_END" << endl;
+	cout << "Prints all failures in BANK with a row in [ROW_BEGIN, ROW_END]." << endl;
+	cout << "The index (LOG.idx) is (re)built when it is missing, older than the log or does not cover all of its records." << endl;
+}
+
+//! Returns true if the index does not exist, is older than the log or does
+//not cover all of its records.
+/*!
+  A log appended to within the timestamp resolution of the file system looks
+ as old as its index, so the record count in the index header is compared
+ with the records in the log as well.
+*/
+bool indexStale(const string& log, const string& index){
+	struct stat ls, is;
+	if(stat(index.c_str(), &is) != 0 || stat(log.c_str(), &ls) != 0)
+		return true;
+
+	if(is.st_mtim.tv_sec != ls.st_mtim.tv_sec ? is.st_mtim.tv_sec < ls.st_mtim.tv_sec :
+			is.st_mtim.tv_nsec < ls.st_mtim.tv_nsec)
+		return true;
+
+	FILE* f = fopen(index.c_str(), "rb");
+	if(!f)
+		return true;
+
+	ErrorFileHeader hdr;
+	bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1;
+	fclose(f);
+
+	uint64_t records = ls.st_size > (off_t)sizeof(ErrorFileHeader) ?
+		(ls.st_size - sizeof(ErrorFileHeader))/sizeof(ErrorRecord) : 0;
+
+	return !ok || hdr.magic != ERRIDX_MAGIC || hdr.count != records;
+}
+
+int main(int argc, char* argv[]){
+	if(argc != 5 || strcmp(argv[1], "--help") == 0){
+		printHelp(argv);
+		return -2;
+	}
+
+	string log(argv[1]);
+	string index = log + ".idx";
+	uint bank = 0, row_begin = 0, row_end = 0;
+
+	try{
+		bank = stoul(argv[2]);
+		row_begin = stoul(argv[3]);
+		row_end = stoul(argv[4]);
+	}catch(...){
+		printHelp(argv);
+		return -3;
+	}
+
+	if(bank >= NUM_BANKS || row_begin > row_end){
+		printHelp(argv);
+		return -4;
+	}
+
+	if(indexStale(log, index) && !ErrorLogReader::buildIndex(log.c_str(), index.c_str())){
+		printf("Could not index %s \n", log.c_str());
+		return -1;
+	}
+
+	ErrorLogReader reader;
+	if(!reader.open(log.c_str(), index.c_str())){
+		printf("Could not open %s \n", log.c_str());
+		return -1;
+	}
+
+	uint64_t n = reader.query(bank, row_begin, row_end, [](const ErrorRecord& r){
+		printf("Run: %u, DIMM: %u, Bank: %u, Row: %u (physical %u), Col: %u, Lane: %u, Mask: %02x, Retention: %u ms, ",
+				r.run_id, r.dimm, r.bank, r.row, r.phys_row, r.col, r.lane, r.mask, r.retention_ms);
+		if(r.pattern > 0 && r.pattern <= NUM_DATA_PATTERNS)
+			printf("Pattern: %s, ", patternName((DATA_PATTERN)(r.pattern - 1)));
+		printf("Time: %llu \n", (unsigned long long)r.timestamp_us);
+	});
+
+	printf("%llu failures in bank %u rows %u-%u (%llu records in the log) \n",
+			(unsigned long long)n, bank, row_begin, row_end, (unsigned long long)reader.size());
+
+	return 0;
+}
@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <riffa.h>
+#include <string.h>
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include "softmc.h"
+#include "fill.h"
+#include "scan.h"
+#include "emulator.h"
+
+using namespace std;
+
+void printHelp(char* argv[]){
+	cout << "A sample application that writes a data pattern to the entire DIMM, or checks it, using SoftMC" << endl;
+	cout << "Usage:" << argv[0] << " [PATTERN] [--scrub] [--verify] [--threads N] [--bank B] [--banks N] [--row R] [--rows N] [--emulate]" << endl;
+	cout << "PATTERN is the byte written to every column, in hex (ff by default). --scrub writes 00." << endl;
+	cout << "--verify reads the rows back and checks them against PATTERN instead, with N verifier threads (" << SCAN_THREADS << " by default)." << endl;
+	cout << "--bank B, --banks N, --row R and --rows N select the rows (the entire DIMM by default)." << endl;
+	cout << "--emulate writes to an emulated board instead of a real one." << endl;
+}
+
+int main(int argc, char* argv[]){
+	if(argc > 1 && strcmp(argv[1], "--help") == 0){
+		printHelp(argv);
+		return -2;
+	}
+
+	uint bank = 0, num_banks = NUM_BANKS, first_row = 0, num_rows = NUM_ROWS, threads = SCAN_THREADS;
+	uint8_t pattern = 0xff;
+	bool emulate = false, verify = false;
+
+	for(int i = 1; i < argc; i++){
+		if(strcmp(argv[i], "--scrub") == 0)
+			pattern = 0x00;
+		else if(strcmp(argv[i], "--verify") == 0)
+			verify = true;
+		else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--bank") == 0 && i + 1 < argc)
+			bank = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--banks") == 0 && i + 1 < argc)
+			num_banks = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--row") == 0 && i + 1 < argc)
+			first_row = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--rows") == 0 && i + 1 < argc)
+			num_rows = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--emulate") == 0)
+			emulate = true;
+		else if(argv[i][0] != '-')
+			pattern = strtoul(argv[i], nullptr, 16);
+		else{
+			printHelp(argv);
+			return -2;
+		}
+	}
+
+	if(bank >= NUM_BANKS || num_banks == 0 || first_row >= NUM_ROWS || num_rows == 0 || threads == 0){
+		printHelp(argv);
+		return -4;
+	}
+
+	Backend* be;
+	if(emulate)
+		be = new EmulatorBackend();
+	else{
+		// Open an FPGA device, so we can read/write from/to it
+		// (this also sends a reset signal, which recovers the FPGA from some unwanted state)
+		be = RiffaBackend::open(0);
+
+		if(!be){
+			printf("Problem on opening the fpga \n");
+			return -1;
+		}
+		printf("The FPGA has been opened successfully! \n");
+	}
+
+	RowRegion region(bank, min(bank + num_banks, (uint)NUM_BANKS), first_row, min(first_row + num_rows, (uint)NUM_ROWS));
+
+	if(verify){
+		const char* bottlenecks[] = {"DRAM", "PCIe", "host"};
+
+		printf("Checking %u rows for %02x! \n", region.size(), pattern);
+
+		ScanStats st = scanRows(be, BankMajorOrder(region), pattern, printError, threads);
+
+		printf("%llu MB in %.1f ms: %.2f GB/s (%.0f%% of the %.1f GB/s peak), %llu errors, hash %016llx \n",
+				(unsigned long long)(st.bytes() >> 20), st.ms, st.gbps(), 100*st.gbps()/DDR3_PEAK_GBPS, DDR3_PEAK_GBPS,
+				(unsigned long long)st.errors, (unsigned long long)st.hash);
+		if(st.lost)
+			printf("%llu of the rows were not checked, their read back was not received or could not be buffered! \n",
+					(unsigned long long)st.lost);
+		printf("DRAM %.1f ms, verifiers %.1f ms over %u threads, waiting for buffers %.1f ms: %s bound \n",
+				st.dram_ms, st.verify_ms, st.threads, st.stall_ms, bottlenecks[(int)st.bottleneck()]);
+		printf("The check has been completed! \n");
+
+		delete be;
+		return 0;
+	}
+
+	printf("Writing %02x to %u rows! \n", pattern, region.size());
+
+	FillStats st = fill(be, BankMajorOrder(region), pattern);
+
+	printf("%llu MB in %.1f ms: %.2f GB/s (%.0f%% of the %.1f GB/s peak) \n", (unsigned long long)(st.bytes() >> 20),
+			st.ms, st.gbps(), 100*st.gbps()/DDR3_PEAK_GBPS, DDR3_PEAK_GBPS);
+	printf("The sequences keep the data bus busy %.1f%% of the time (%.2f GB/s) \n", 100*st.bus_efficiency, st.busGbps());
+	printf("The fill has been completed! \n");
+
+	delete be;
+	return 0;
+}
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <riffa.h>
+#include <string.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "softmc.h"
+#include "latency.h"
+#include "emulator.h"
+
+using namespace std;
+
+void printHelp(char* argv[]){
+	cout << "A sample application that finds the smallest activation (tRCD), precharge (tRP), restoration (tRAS), write recovery (tWR)" << endl;
+	cout << " or read to precharge (tRTP) latency each DRAM row works with using SoftMC" << endl;
+	cout << "Usage:" << argv[0] << " [--trcd | --trp | --tras | --twr | --trtp [--ap]] [--bank B] [--banks N] [--row R] [--rows N] [--min C] [--trials N] [--out FILE] [--emulate]" << endl;
+	cout << "--trcd (default) tests the ACT to RD gap, --trp the PRE to ACT gap and --tras the ACT to PRE gap." << endl;
+	cout << "--twr tests the WR to PRE gap (CWL, the burst and tWR, " << SPEC_TWR_CYCLES << " cycles) and --trtp the RD to PRE gap (" << SPEC_TRTP_CYCLES << " cycles)." << endl;
+	cout << " With --ap they use auto-precharge instead and test the gap to the next ACT of the row (" << recoverySpec(true, AUTO_PRECHARGE::AP)
+		<< " and " << recoverySpec(false, AUTO_PRECHARGE::AP) << " cycles)." << endl;
+	cout << "--bank B, --banks N, --row R and --rows N select the rows to test (bank 0, rows 0-1023 by default). Rows of" << endl;
+	cout << " different banks are visited in turn, so that the tRP and tRAS measurements of the banks overlap." << endl;
+	cout << "--min C is the smallest gap to try, in cycles (1 by default, our sequences use " << SPEC_TRCD_CYCLES << ", "
+		<< SPEC_TRP_CYCLES << " and " << SPEC_TRAS_CYCLES << ")." << endl;
+	cout << "--trials N tests every gap N times (1 by default)." << endl;
+	cout << "--out FILE writes the smallest gap of each column region to FILE, one row per line:" << endl;
+	cout << " BANK ROW and " << LATENCY_REGIONS << " gaps of " << LATENCY_REGION_COLS << " columns each (" << LATENCY_UNRELIABLE << " if the region failed with every gap)." << endl;
+	cout << "--emulate tests an emulated board instead of a real one." << endl;
+}
+
+int main(int argc, char* argv[]){
+	if(argc > 1 && strcmp(argv[1], "--help") == 0){
+		printHelp(argv);
+		return -2;
+	}
+
+	uint bank = 0, num_banks = 1, first_row = 0, num_rows = 1024, min_cycles = 1, trials = 1;
+	string timing = "tRCD";
+	uint spec = SPEC_TRCD_CYCLES;
+	string out;
+	bool emulate = false;
+	AUTO_PRECHARGE ap = AUTO_PRECHARGE::NO_AP;
+
+	for(int i = 1; i < argc; i++){
+		if(strcmp(argv[i], "--trcd") == 0){
+			timing = "tRCD";
+			spec = SPEC_TRCD_CYCLES;
+		}
+		else if(strcmp(argv[i], "--trp") == 0){
+			timing = "tRP";
+			spec = SPEC_TRP_CYCLES;
+		}
+		else if(strcmp(argv[i], "--tras") == 0){
+			timing = "tRAS";
+			spec = SPEC_TRAS_CYCLES;
+		}
+		else if(strcmp(argv[i], "--twr") == 0)
+			timing = "tWR";
+		else if(strcmp(argv[i], "--trtp") == 0)
+			timing = "tRTP";
+		else if(strcmp(argv[i], "--ap") == 0)
+			ap = AUTO_PRECHARGE::AP;
+		else if(strcmp(argv[i], "--bank") == 0 && i + 1 < argc)
+			bank = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--banks") == 0 && i + 1 < argc)
+			num_banks = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--row") == 0 && i + 1 < argc)
+			first_row = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--rows") == 0 && i + 1 < argc)
+			num_rows = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--min") == 0 && i + 1 < argc)
+			min_cycles = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--trials") == 0 && i + 1 < argc)
+			trials = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			out = argv[++i];
+		else if(strcmp(argv[i], "--emulate") == 0)
+			emulate = true;
+		else{
+			printHelp(argv);
+			return -2;
+		}
+	}
+
+	bool recovery = timing == "tWR" || timing == "tRTP";
+	if(recovery)
+		spec = recoverySpec(timing == "tWR", ap);
+
+	if((ap == AUTO_PRECHARGE::AP && !recovery) || bank >= NUM_BANKS || num_banks == 0 || bank + num_banks > NUM_BANKS || first_row >= NUM_ROWS ||
+			num_rows == 0 || min_cycles < 1 || min_cycles > spec || trials == 0){
+		printHelp(argv);
+		return -4;
+	}
+
+	FILE* f = nullptr;
+	if(!out.empty() && !(f = fopen(out.c_str(), "w"))){
+		printf("Could not open %s \n", out.c_str());
+		return -1;
+	}
+
+	Backend* be;
+	if(emulate)
+		be = new EmulatorBackend();
+	else{
+		// Open an FPGA device, so we can read/write from/to it
+		// (this also sends a reset signal, which recovers the FPGA from some unwanted state)
+		be = RiffaBackend::open(0);
+
+		if(!be){
+			printf("Problem on opening the fpga \n");
+			return -1;
+		}
+		printf("The FPGA has been opened successfully! \n");
+	}
+
+	RowRegion region(bank, bank + num_banks, first_row, min(first_row + num_rows, (uint)NUM_ROWS));
+	string label = ap == AUTO_PRECHARGE::AP ? timing + " (auto-precharge)" : timing;
+	printf("Starting %s Test on %u rows! \n", label.c_str(), region.size());
+
+	BankInterleavedOrder order(region);
+	vector<RowLatency> lat = timing == "tWR" ? characterizeTwr(be, order, 0xff, ap, min_cycles, trials, true) :
+		timing == "tRTP" ? characterizeTrtp(be, order, 0xff, ap, min_cycles, trials, true) :
+		timing == "tRAS" ? characterizeTras(be, order, 0xff, min_cycles, trials, true) :
+		timing == "tRP" ? characterizeTrp(be, order, 0xff, min_cycles, trials, true) :
+		characterizeTrcd(be, order, 0xff, min_cycles, trials, true);
+
+	// rows by the gap their slowest region needs
+	vector<uint> hist(spec + 1, 0);
+	uint unreliable = 0;
+	for(const RowLatency& l : lat){
+		if(l.max() == LATENCY_UNRELIABLE)
+			unreliable++;
+		else
+			hist[l.max()]++;
+
+		if(f){
+			fprintf(f, "%u %u", l.addr.bank, l.addr.row);
+			for(uint r = 0; r < LATENCY_REGIONS; r++)
+				fprintf(f, " %u", l.cycles[r]);
+			fprintf(f, "\n");
+		}
+	}
+
+	for(uint c = min_cycles; c <= spec; c++)
+		printf("%s %u cycles (%.1f ns): %u rows \n", label.c_str(), c, c*2.5, hist[c]);
+	if(unreliable)
+		printf("%u rows failed with the spec %s \n", unreliable, label.c_str());
+
+	if(f)
+		fclose(f);
+
+	printf("The test has been completed! \n");
+
+	delete be;
+	return 0;
+}
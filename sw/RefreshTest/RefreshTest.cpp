@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <riffa.h>
+#include <string.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <time.h>
+#include "softmc.h"
+#include "refresh.h"
+#include "errlog.h"
+#include "emulator.h"
+
+using namespace std;
+
+void printHelp(char* argv[]){
+	cout << "A sample application that measures the failures of the DIMM when the refresh engine of SoftMC refreshes it" << endl;
+	cout << " less often than every " << SPEC_TREFI_TICKS*REF_TICK_NS/1000.0 << " us (tREFI)" << endl;
+	cout << "Usage:" << argv[0] << " [PATTERN] [--intervals M1,M2,...] [--passes N] [--slices N] [--bank B] [--banks N] [--row R] [--rows N] [--log FILE] [--emulate]" << endl;
+	cout << "PATTERN is the byte written to every column, in hex (ff by default)." << endl;
+	cout << "--intervals are the multiples of tREFI to run the refresh engine at (1,2,4,8 by default)." << endl;
+	cout << "--passes N scans the rows N times at every interval (1 by default)." << endl;
+	cout << "--slices N splits the rows into N slices that are written and scanned in turn while the others wait for" << endl;
+	cout << " " << REFRESH_DWELL_WINDOWS << " refresh windows (" << REFRESH_SLICES << " by default)." << endl;
+	cout << "--bank B, --banks N, --row R and --rows N select the rows (the entire DIMM by default)." << endl;
+	cout << "--log FILE appends the errors to FILE in the binary format read by SoftMC_ErrorQuery instead of printing them," << endl;
+	cout << " with the refresh window of the interval as their retention time." << endl;
+	cout << "--emulate tests an emulated board instead of a real one." << endl;
+}
+
+int main(int argc, char* argv[]){
+	if(argc > 1 && strcmp(argv[1], "--help") == 0){
+		printHelp(argv);
+		return -2;
+	}
+
+	uint bank = 0, num_banks = NUM_BANKS, first_row = 0, num_rows = NUM_ROWS, passes = 1, slices = REFRESH_SLICES;
+	vector<uint> intervals = {1, 2, 4, 8};
+	uint8_t pattern = 0xff;
+	bool emulate = false;
+	const char* log_path = nullptr;
+
+	for(int i = 1; i < argc; i++){
+		if(strcmp(argv[i], "--intervals") == 0 && i + 1 < argc){
+			intervals.clear();
+			stringstream ss(argv[++i]);
+			string t;
+			while(getline(ss, t, ','))
+				intervals.push_back(atoi(t.c_str()));
+		}
+		else if(strcmp(argv[i], "--passes") == 0 && i + 1 < argc)
+			passes = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--slices") == 0 && i + 1 < argc)
+			slices = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--bank") == 0 && i + 1 < argc)
+			bank = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--banks") == 0 && i + 1 < argc)
+			num_banks = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--row") == 0 && i + 1 < argc)
+			first_row = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--rows") == 0 && i + 1 < argc)
+			num_rows = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--log") == 0 && i + 1 < argc)
+			log_path = argv[++i];
+		else if(strcmp(argv[i], "--emulate") == 0)
+			emulate = true;
+		else if(argv[i][0] != '-')
+			pattern = strtoul(argv[i], nullptr, 16);
+		else{
+			printHelp(argv);
+			return -2;
+		}
+	}
+
+	if(intervals.empty() || find(intervals.begin(), intervals.end(), 0u) != intervals.end() || passes == 0 ||
+			slices == 0 || bank >= NUM_BANKS || num_banks == 0 || first_row >= NUM_ROWS || num_rows == 0){
+		printHelp(argv);
+		return -4;
+	}
+
+	ErrorLogWriter* log = nullptr;
+	if(log_path){
+		log = new ErrorLogWriter(log_path, (uint32_t)time(nullptr), 0);
+
+		if(!log->good()){
+			printf("Could not open the error log %s \n", log_path);
+			delete log;
+			return -1;
+		}
+		printf("Logging errors of run %u to %s \n", log->run_id, log_path);
+	}
+
+	Backend* be;
+	if(emulate)
+		be = new EmulatorBackend();
+	else{
+		// Open an FPGA device, so we can read/write from/to it
+		// (this also sends a reset signal, which recovers the FPGA from some unwanted state)
+		be = RiffaBackend::open(0);
+
+		if(!be){
+			printf("Problem on opening the fpga \n");
+			delete log;
+			return -1;
+		}
+		printf("The FPGA has been opened successfully! \n");
+	}
+
+	RowRegion region(bank, min(bank + num_banks, (uint)NUM_BANKS), first_row, min(first_row + num_rows, (uint)NUM_ROWS));
+
+	printf("Testing %u rows with %02x at %u refresh intervals! \n", region.size(), pattern, (uint)intervals.size());
+
+	vector<RefreshStats> stats = sweepRefresh(be, intervals, BankMajorOrder(region), pattern,
+			[log](uint multiplier, const ReadError& err){
+				if(log){
+					RefreshStats st(multiplier, SPEC_TREFI_TICKS*multiplier);
+					log->add(err, log->dimm, (uint32_t)(st.windowMs() + 0.5));
+					return;
+				}
+
+				fprintf(stderr, "tREFI: %ux ", multiplier);
+				printError(err);
+			}, passes, slices, true);
+
+	printf("tREFI\twindow (ms)\trows\tlost\terrors\tbit flips\tcells\tflip rate\ttime (ms)\twaiting (ms) \n");
+	for(const RefreshStats& st : stats)
+		printf("%ux\t%.1f\t\t%llu\t%llu\t%llu\t%llu\t\t%llu\t%.3g\t\t%.0f\t\t%.0f \n", st.multiplier, st.windowMs(),
+				(unsigned long long)st.rows, (unsigned long long)st.lost, (unsigned long long)st.errors, (unsigned long long)st.flips,
+				(unsigned long long)st.cells, st.rate(), st.ms, st.wait_ms);
+
+	printf("The refresh test has been completed! \n");
+
+	delete log;
+	delete be;
+	return 0;
+}
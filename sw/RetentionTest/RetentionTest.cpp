@@ -4,263 +4,420 @@
 #include <string.h>
 #include <iostream>
 #include <cmath>
+#include <ctime>
+#include <sstream>
+#include <algorithm>
 #include "softmc.h"
+#include "retention.h"
+#include "emulator.h"
+#include "cluster.h"
+#include "errlog.h"
+#include "weakcells.h"
+#include "cellmap.h"
+#include "sweep.h"
+#include "vrt.h"
+#include "patterns.h"
 
 using namespace std;
 
-//Note that capacity of the instruction buffer is 8192 instructions
-void writeRow(fpga_t* fpga, uint row, uint bank, uint8_t pattern, InstructionSequence*& iseq){
+//number of rows in each shard that the boards of a cluster share
+#define SHARD_ROWS 4096
+//number of retention times probed by --profile
+#define PROFILE_LEVELS 8
+//number of passes of --monitor
+#define MONITOR_PASSES 24
+//a weak cell database is compacted at the end of a run once its file has this many entries per cell
+#define DB_COMPACT_RATIO 4
 
-	if(iseq == nullptr)
-		iseq = new InstructionSequence();
-	else
-		iseq->size = 0;//reuse the provided InstructionSequence to avoid dynamic allocation on each call
-
-	//Precharge target bank (just in case if its left activated)
-	iseq->insert(genPRE(bank, PRE_TYPE::SINGLE));
-
-	//Wait for tRP
-	iseq->insert(genWAIT(5));//2.5ns have already been passed as we issue in next cycle. So, 5 means 6 cycles latency, 15 ns
-
-	//Activate target row
-	iseq->insert(genACT(bank, row));
+void printHelp(char* argv[]){
+	cout << "A sample application that tests retention time of DRAM cells using SoftMC" << endl;
+	cout << "Usage:" << argv[0] << " [REFRESH INTERVAL] [--all-boards | --emulate N] [--spread] [--log FILE] [--db FILE] [--profile MIN | --sweep T1,T2,... | --monitor PERIOD [--passes N] | --patterns P1,P2,... [--split bank|group]] [--resume FILE] [--order ORDER] [--row-map FILE] [--skip-weak]" << endl;
+	cout << "The Refresh Interval should be a positive integer, indicating the target retention time in milliseconds." << endl;
+	cout << "--all-boards tests the DIMMs of all boards listed by the driver at the same time." << endl;
+	cout << "--emulate N tests N emulated boards instead of real ones." << endl;
+	cout << "--spread tests every row once, on whichever of the boards is idle, instead of every row of every DIMM (for DIMMs of the same part)." << endl;
+	cout << "--log FILE appends the errors to FILE in the binary format read by SoftMC_ErrorQuery instead of printing them." << endl;
+	cout << "--db FILE adds the failing cells to the weak cell database in FILE (FILE.N for DIMM N when testing several boards)." << endl;
+	cout << "--skip-weak skips the rows with a cell in the --db database that failed at REFRESH INTERVAL (the shortest --sweep time)" << endl;
+	cout << " or a shorter time (single board only, not with --resume)." << endl;
+	cout << "--profile MIN finds the retention time of every row between MIN and REFRESH INTERVAL ms instead (single board only)." << endl;
+	cout << "--sweep T1,T2,... tests the retention times T1, T2, ... ms (and REFRESH INTERVAL) in a single pass (single board only)." << endl;
+	cout << "--monitor PERIOD re-tests the rows of the cells in the --db database that failed at REFRESH INTERVAL every PERIOD seconds," << endl;
+	cout << " N times (" << MONITOR_PASSES << " by default), and reports the cells that switch between failing and passing (single board only)." << endl;
+	cout << "--patterns P1,P2,... tests the data patterns (all0, all1, checkerboard, rowstripe, colstripe, walking1, random or all)" << endl;
+	cout << " in a single pass, each in its own banks (--split bank, default) or row groups of " << PATTERN_GROUP_ROWS << " rows (--split group) (single board only)." << endl;
+	cout << "--resume FILE keeps the progress of the test in FILE and continues from there if it was interrupted (single board only)." << endl;
+	cout << "--order visits the rows bank by bank (major, default), interleaved across banks (interleaved), one subarray after the other (subarray) or in a random order (random) (single board only)." << endl;
+	cout << "--row-map FILE reads the physical row of the logical rows from FILE (\"logical physical\" lines). The log then records physical rows and --order visits physical rows." << endl;
+}
 
-	//Wait for tRCD
-	iseq->insert(genWAIT(5));
+//! Where the errors of a run go.
+class Results{
 
-	//Write to the entire row
-	for(int i = 0; i < NUM_COLS; i+=8){ //we use 8x burst mode
-		iseq->insert(genWR(bank, i, pattern));
+	public:
+		uint32_t run_id;
+		int retention;
+		ErrorLogWriter* log;
+		vector<WeakCellDb*> dbs; //one per DIMM
+		bool print_dimm;
+		bool compact; //the databases may be rewritten at the end of the run
 
-		//We need to wait for tCL and 4 cycles burst (double data-rate)
-		iseq->insert(genWAIT(6 + 4));
-	}
+		Results(uint32_t run_id, int retention){
+			this->run_id = run_id; this->retention = retention;
+			log = nullptr; print_dimm = false; compact = true;
+		}
 
-	//Wait some more in any case
-	iseq->insert(genWAIT(3));
+		~Results(){
+			delete log;
+			for(WeakCellDb* db : dbs){
+				// every run appends an entry per failure, so the file keeps growing
+				if(compact && db->fileEntries() > (uint64_t)DB_COMPACT_RATIO*db->size() && !db->compact())
+					printf("Could not compact the weak cell database \n");
+				delete db;
+			}
+		}
 
-	//Precharge target bank
-	iseq->insert(genPRE(bank, PRE_TYPE::SINGLE));
+		bool openDbs(const char* path, uint num_dimms){
+			for(uint d = 0; d < num_dimms; d++){
+				string p = num_dimms == 1 ? string(path) : string(path) + "." + to_string(d);
+				dbs.push_back(new WeakCellDb());
 
-	//Wait for tRP
-	iseq->insert(genWAIT(5));//we have already 2.5ns passed as we issue in next cycle. So, 5 means 6 cycles latency, 15 ns
+				if(!dbs.back()->open(p.c_str())){
+					printf("Could not open the weak cell database %s \n", p.c_str());
+					return false;
+				}
+				printf("DIMM %u: %zu known weak cells in %s \n", d, dbs.back()->size(), p.c_str());
+			}
+			return true;
+		}
 
-	//START Transaction
-	iseq->insert(genEND());
+		//! Makes the errors reported so far durable.
+		void flush(){
+			if(log)
+				log->flush();
+			for(WeakCellDb* db : dbs)
+				db->commit();
+		}
 
-	iseq->execute(fpga);
-}
+		void add(const ReadError& e, uint dimm){
+			add(e, dimm, retention);
+		}
 
-void readAndCompareRow(fpga_t* fpga, const uint row, const uint bank, const uint8_t pattern, InstructionSequence*& iseq){
+		void add(const ReadError& e, uint dimm, int retention){
+			add(e, dimm, retention, 0);
+		}
 
-	if(iseq == nullptr)
-		iseq = new InstructionSequence();
-	else
-		iseq->size = 0;//reuse the provided InstructionSequence to avoid dynamic allocation for each call
+		void add(const ReadError& e, DATA_PATTERN p){
+			add(e, 0, retention, (uint8_t)p + 1);
+		}
 
-	//Precharge target bank (just in case if its left activated)
-	iseq->insert(genPRE(bank, PRE_TYPE::SINGLE));
+	private:
+		//! \e pattern is the DATA_PATTERN + 1 of a data pattern test, 0 otherwise.
+		void add(const ReadError& e, uint dimm, int retention, uint8_t pattern){
+			if(log)
+				log->add(e, dimm, retention, pattern);
+			if(dimm < dbs.size())
+				dbs[dimm]->record(e, retention, run_id);
+
+			if(log || !dbs.empty())
+				return;
+
+			if(retention != this->retention)
+				fprintf(stderr, "Retention: %d ms ", retention);
+			if(print_dimm)
+				fprintf(stderr, "DIMM: %d ", dimm);
+			if(pattern)
+				fprintf(stderr, "Pattern: %s ", patternName((DATA_PATTERN)(pattern - 1)));
+			printError(e);
+		}
+};
 
-	//Wait for tRP
-	iseq->insert(genWAIT(5));//2.5ns have already been passed as we issue in next cycle. So, 5 means 6 cycles latency, 15 ns
+static const char* stateName(CELL_STATE s){
+	return s == CELL_STATE::FAIL ? "FAIL" : s == CELL_STATE::PASS ? "PASS" : "?";
+}
 
-	//Activate target row
-	iseq->insert(genACT(bank, row));
+//! Monitors the known weak cells of the DIMM for variable retention times.
+void monitorVrt(Backend* be, const int retention, const uint period_s, const uint passes, Results& results){
+	VrtMonitor mon(retention);
+	mon.track(*results.dbs[0]);
 
-	//Wait for tRCD
-	iseq->insert(genWAIT(5));
+	printf("Monitoring %zu known weak cells in %zu rows (%.3f%% of the DIMM) @ %d ms every %u s! \n", mon.cells.size(),
+			mon.rows.size(), 100.0*mon.rows.size()/NUM_DIMM_ROWS, retention, period_s);
 
-	//Read the entire row
-	for(int i = 0; i < NUM_COLS; i+=8){ //we use 8x burst mode
-		iseq->insert(genRD(bank, i));
+	mon.run(be, passes, period_s*1000, 0xff, [](const VrtTransition& t){
+		DramAddr addr;
+		uint col, lane, bit;
+		CellBitmap::cellAddr(t.cell, addr, col, lane, bit);
 
-		//We need to wait for tCL and 4 cycles burst (double data-rate)
-		iseq->insert(genWAIT(6 + 4));
+		printf("%c[2K\r", 27);
+		printf("Pass: %u, Time: %.1f s, Bank: %u, Row: %u, Col: %u, Lane: %u, Bit: %u, %s -> %s \n", t.pass, t.elapsed_ms/1000,
+				addr.bank, addr.row, col, lane, bit, stateName(t.from), stateName(t.to));
+	}, [&results](const ReadError& e){ results.add(e, 0); }, true);
+
+	for(const auto& kv : mon.cells){
+		const VrtCell& c = kv.second;
+		if(!c.transitions)
+			continue;
+
+		DramAddr addr;
+		uint col, lane, bit;
+		CellBitmap::cellAddr(c.cell, addr, col, lane, bit);
+		printf("VRT cell Bank: %u, Row: %u, Col: %u, Lane: %u, Bit: %u failed in %u of %u passes, %u transitions \n",
+				addr.bank, addr.row, col, lane, bit, c.fails, mon.passes, c.transitions);
 	}
+	printf("%u of %zu cells changed their state \n", mon.vrtCells(), mon.cells.size());
+}
 
-	//Wait some more in any case
-	iseq->insert(genWAIT(3));
-
-	//Precharge target bank
-	iseq->insert(genPRE(bank, PRE_TYPE::SINGLE)); //pre 1 -> precharge all, pre 0 precharge bank
-
-	//Wait for tRP
-	iseq->insert(genWAIT(5));//we have already 2.5ns passed as we issue in next cycle. So, 5 means 6 cycles latency, 15 ns
-
-	//START Transaction
-	iseq->insert(genEND());
+//! Tests several data patterns at once and reports the failures of each.
+void testPatternSuite(Backend* be, const int retention, const vector<DATA_PATTERN>& patterns, const PATTERN_SPLIT split,
+		Results& results){
 
-	iseq->execute(fpga);
+	printf("Starting Data Pattern Test @ %d ms with %zu patterns! \n", retention, patterns.size());
 
-	//Receive the data
-	uint rbuf[16];
-	for(int i = 0; i < NUM_COLS; i+=8){ //we receive a single burst at two times (32 bytes each)
-		fpga_recv(fpga, 0, (void*)rbuf, 16, 0);
+	vector<PatternStats> stats = testPatterns(be, retention, BankMajorOrder(), patterns, split,
+			[&results](DATA_PATTERN p, const ReadError& e){ results.add(e, p); }, 1, true);
 
-		//compare with the pattern
-		uint8_t* rbuf8 = (uint8_t *) rbuf;
+	printf("Pattern\t\trows\terrors\tbit flips\tfailing rows\tflip rate \n");
+	for(const PatternStats& st : stats)
+		printf("%-12s\t%llu\t%llu\t%llu\t\t%llu\t\t%.3g \n", patternName(st.pattern), (unsigned long long)st.rows,
+				(unsigned long long)st.errors, (unsigned long long)st.flips, (unsigned long long)st.failing_rows, st.rate());
+}
 
-		for(int j = 0; j < 64; j++){
-			if(rbuf8[j] != pattern)
-				fprintf(stderr, "Error at Col: %d, Row: %u, Bank: %u, DATA: %x \n", i, row, bank, rbuf8[j]);
+//! Tests all DIMMs of the cluster and reports the merged errors.
+void testCluster(softmc::Cluster* cluster, const int retention, const bool spread, Results& results){
+	const uint8_t pattern = 0xff; //the data pattern that we write to the DRAM
+
+	// unpinned shards are stolen by the boards that finish first
+	vector<softmc::Shard> shards;
+	if(spread)
+		shards = softmc::Cluster::split(ANY_DIMM, SHARD_ROWS);
+	else{
+		for(uint d = 0; d < cluster->size(); d++){
+			vector<softmc::Shard> dimm = softmc::Cluster::split(d, SHARD_ROWS);
+			shards.insert(shards.end(), dimm.begin(), dimm.end());
 		}
 	}
-}
-
-void turnBus(fpga_t* fpga, BUSDIR b, InstructionSequence* iseq = nullptr){
 
-	if(iseq == nullptr)
-		iseq = new InstructionSequence();
-	else
-		iseq->size = 0;//reuse the provided InstructionSequence to avoid dynamic allocation for each call
+	// a model per board, calibrated by its first shard and only used by its worker thread
+	vector<ThroughputModel> models(cluster->size());
 
-	iseq->insert(genBUSDIR(b));
+	softmc::TestPlan plan = [cluster, &models, retention, pattern](Backend* be, const softmc::Shard& s,
+			const ErrorSink& sink){
+		uint d = 0;
+		while(cluster->board(d) != be)
+			d++;
 
-	//WAIT
-	iseq->insert(genWAIT(5));
+		if(!models[d].calibrated())
+			models[d].calibrate(be, DramAddr(s.row_begin, s.bank), pattern);
 
-	//START Transaction
-	iseq->insert(genEND());
+		testRetention(be, retention, DramAddr(s.row_begin, s.bank), s.row_end - s.row_begin, pattern, sink,
+				false, &models[d]);
+	};
 
-	iseq->execute(fpga);	
+	results.print_dimm = true;
+	cluster->run(plan, shards, [&results](int dimm, const ReadError& e){ results.add(e, dimm); });
 }
 
+int main(int argc, char* argv[]){
+	fpga_info_list info;
+	int fid = 0; //fpga id
+	bool all_boards = false;
+	bool spread = false;
+	int emulated = 0;
+	const char* log_path = nullptr;
+	const char* db_path = nullptr;
+	int profile_min = 0;
+	vector<int> sweep;
+	int monitor = 0;
+	int monitor_passes = MONITOR_PASSES;
+	vector<DATA_PATTERN> patterns;
+	bool bad_pattern = false;
+	PATTERN_SPLIT split = PATTERN_SPLIT::BANK;
+	string split_name = "bank";
+	const char* resume_path = nullptr;
+	string order_name = "major";
+	const char* map_path = nullptr;
+	bool skip_weak = false;
+
+	if(argc < 2 || strcmp(argv[1], "--help") == 0){
+		printHelp(argv);
+		return -2;
+	}
 
-//! Runs a test to check the DRAM cells against the given retention time.
-/*!
-  \param \e fpga is a pointer to the RIFFA FPGA device.
-  \param \e retention is the retention time in milliseconds to test.
-*/
-void testRetention(fpga_t* fpga, const int retention){
-
-	uint8_t pattern = 0xff; //the data pattern that we write to the DRAM
-
-	bool dimm_done = false;
-
-	InstructionSequence* iseq = nullptr; // we temporarily store (before sending them to the FPGA) the generated instructions here
-
-	GET_TIME_INIT(2);
+    string s_ref(argv[1]);
+    int refresh_interval = 0;
 
-	//writing the entire row takes approximately 5 ms
-	uint group_size = ceil(retention/5.0f); //number of rows to be written in a single iteration
-	uint cur_row_write = 0;
-	uint cur_bank_write = 0;
-	uint cur_row_read = 0;
-	uint cur_bank_read = 0;
+    try{
+        refresh_interval = stoi(s_ref);
+    }catch(...){
+        printHelp(argv);
+        return -3;
+    }
 
-    printf("\n");
+    if(refresh_interval <= 0){
+        printHelp(argv);
+        return -4;
+    }
 
-	while(!dimm_done){ //continue until we cover the entire DRAM
-		//print the number of the row that we are about to test
-		printf("%c[2K\r", 27);
-        printf("Current Bank: %d, Row: %d", cur_bank_write, cur_row_write);
-		fflush(stdout);
-        
-		// Switch the memory bus to write mode
-		turnBus(fpga, BUSDIR::WRITE, iseq);
-
-		GET_TIME_VAL(0);
-
-		// We write to a chunk of rows (group_size) successively
-		for(int i = 0; i < group_size; i++){
-			// write the data pattern to the entire row
-			writeRow(fpga, cur_row_write, cur_bank_write, pattern, iseq);
-			cur_row_write++;
-
-			// when we complete testing all of the rows in a bank, we move to the next bank
-			if(cur_row_write == NUM_ROWS){
-				cur_row_write = 0;
-				cur_bank_write++;
-			}
-		
-			// the entire DIMM is covered when we complete testing all of the bank
-			if(cur_bank_write == NUM_BANKS){
-				// we are done with the entire DIMM
-				dimm_done = true;
-				break;
+	for(int i = 2; i < argc; i++){
+		if(strcmp(argv[i], "--all-boards") == 0)
+			all_boards = true;
+		else if(strcmp(argv[i], "--spread") == 0)
+			spread = true;
+		else if(strcmp(argv[i], "--emulate") == 0 && i + 1 < argc)
+			emulated = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--log") == 0 && i + 1 < argc)
+			log_path = argv[++i];
+		else if(strcmp(argv[i], "--db") == 0 && i + 1 < argc)
+			db_path = argv[++i];
+		else if(strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+			profile_min = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--row-map") == 0 && i + 1 < argc)
+			map_path = argv[++i];
+		else if(strcmp(argv[i], "--order") == 0 && i + 1 < argc)
+			order_name = argv[++i];
+		else if(strcmp(argv[i], "--skip-weak") == 0)
+			skip_weak = true;
+		else if(strcmp(argv[i], "--resume") == 0 && i + 1 < argc)
+			resume_path = argv[++i];
+		else if(strcmp(argv[i], "--monitor") == 0 && i + 1 < argc)
+			monitor = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--passes") == 0 && i + 1 < argc)
+			monitor_passes = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--patterns") == 0 && i + 1 < argc){
+			stringstream ss(argv[++i]);
+			string t;
+			while(getline(ss, t, ',')){
+				DATA_PATTERN p;
+				if(t == "all")
+					for(int j = 0; j < NUM_DATA_PATTERNS; j++)
+						patterns.push_back((DATA_PATTERN)j);
+				else if(parsePattern(t, p))
+					patterns.push_back(p);
+				else
+					bad_pattern = true;
 			}
 		}
+		else if(strcmp(argv[i], "--split") == 0 && i + 1 < argc)
+			split_name = argv[++i];
+		else if(strcmp(argv[i], "--sweep") == 0 && i + 1 < argc){
+			stringstream ss(argv[++i]);
+			string t;
+			while(getline(ss, t, ','))
+				sweep.push_back(atoi(t.c_str()));
+		}
+		else{
+			printHelp(argv);
+			return -2;
+		}
+	}
 
-		// Switch the memory bus to read mode
-		turnBus(fpga, BUSDIR::READ, iseq);
-
-		// wait for the specified retention time (retention)
-		do{
-			GET_TIME_VAL(1);
-		} while((TIME_VAL_TO_MS(1) - TIME_VAL_TO_MS(0)) < retention);
+	if((all_boards && emulated > 0) || profile_min < 0 || profile_min > refresh_interval ||
+			((profile_min > 0 || !sweep.empty()) && (all_boards || emulated > 0)) ||
+			(profile_min > 0 && !sweep.empty()) ||
+			monitor < 0 || monitor_passes <= 0 || bad_pattern ||
+			(spread && !all_boards && emulated <= 1) ||
+			(split_name != "bank" && split_name != "group") ||
+			(!patterns.empty() && (all_boards || emulated > 1 || profile_min > 0 || !sweep.empty() || monitor > 0 || resume_path)) ||
+			(monitor > 0 && (!db_path || all_boards || emulated > 1 || profile_min > 0 || !sweep.empty() || resume_path)) ||
+			(resume_path && (all_boards || emulated > 0 || profile_min > 0)) ||
+			(skip_weak && (!db_path || all_boards || emulated > 0 || profile_min > 0 || monitor > 0 || !patterns.empty() ||
+				resume_path)) ||
+			(order_name != "major" && (all_boards || emulated > 0 || profile_min > 0)) ||
+			(order_name != "major" && order_name != "interleaved" && order_name != "subarray" && order_name != "random") ||
+			any_of(sweep.begin(), sweep.end(), [](int t){ return t <= 0; })){
+		printHelp(argv);
+		return -2;
+	}
 
-		// Read the data back and compare
-		for(int i = 0; i < group_size; i++){
-			readAndCompareRow(fpga, cur_row_read, cur_bank_read, pattern, iseq);
+	if(split_name == "group")
+		split = PATTERN_SPLIT::ROW_GROUP;
 
-			cur_row_read++;
+	Results results((uint32_t)time(nullptr), refresh_interval);
+	// the checkpoint journals the size of the database, which compacting changes
+	results.compact = resume_path == nullptr;
 
-			if(cur_row_read == NUM_ROWS){ //NUM_ROWS
-				cur_row_read = 0;
-				cur_bank_read++;
-			}
-		
-			if(cur_bank_read == NUM_BANKS){ //NUM_BANKS
-				//we are done with the entire DIMM
-				break;
-			}
+	RowMap row_map;
+	if(map_path){
+		TableMapping table;
+		if(!table.load(map_path) || !row_map.set(table)){
+			printf("Could not load a valid row mapping from %s \n", map_path);
+			return -1;
 		}
 	}
 
-	printf("\n");
+	Checkpoint* ckpt = nullptr;
+	if(resume_path){
+		// the journal is only valid for the same test
+		string key = "pattern=ff rows=0+" + to_string(NUM_DIMM_ROWS) + " order=" + order_name +
+			" map=" + (map_path ? map_path : "none") + " log=" + (log_path ? log_path : "none") +
+			" db=" + (db_path ? db_path : "none") + " retention=";
+		if(sweep.empty())
+			key += to_string(refresh_interval);
+		for(uint i = 0; i < sweep.size(); i++)
+			key += (i ? "," : "") + to_string(sweep[i]);
+
+		// the results of the rows that are not in the journal are cut from the log and the database
+		ckpt = new Checkpoint();
+		if(log_path)
+			ckpt->outputs.push_back(log_path);
+		if(db_path)
+			ckpt->outputs.push_back(db_path);
+
+		if(!ckpt->open(resume_path, key)){
+			printf("Could not open the checkpoint %s \n", resume_path);
+			delete ckpt;
+			return -1;
+		}
+		ckpt->before_sync = [&results](){ results.flush(); };
 
-	delete iseq;
-}
+		uint64_t done = 0;
+		for(int t : sweep.empty() ? vector<int>(1, refresh_interval) : sweep)
+			done += ckpt->doneRows(t);
+		if(done)
+			printf("Resuming, %llu rows have already been tested \n", (unsigned long long)done);
+	}
 
-// provide trefi = 0 to disable auto-refresh
-// auto-refresh is disabled by default (disabled after FPGA boots, disables on pushing reset button)
-void setRefreshConfig(fpga_t* fpga, uint trefi, uint trfc){
-	InstructionSequence* iseq = new InstructionSequence;
+	if(log_path){
+		results.log = new ErrorLogWriter(log_path, results.run_id, refresh_interval);
 
-	iseq->insert(genREF_CONFIG(trfc, REGISTER::TRFC));
-	iseq->insert(genREF_CONFIG(trefi, REGISTER::TREFI));
+		if(!results.log->good()){
+			printf("Could not open the error log %s \n", log_path);
+			return -1;
+		}
+		printf("Logging errors of run %u to %s \n", results.run_id, log_path);
+		results.log->map = &row_map;
+	}
 
-	//START Transaction
-	iseq->insert(genEND());
+	if(emulated > 0){
+		vector<Backend*> boards;
+		for(int i = 0; i < emulated; i++)
+			boards.push_back(new EmulatorBackend(i + 1));
 
-	iseq->execute(fpga);	
+		softmc::Cluster cluster(boards);
 
-	delete iseq;
-}
+		if(db_path && !results.openDbs(db_path, emulated))
+			return -1;
 
+		if(monitor > 0){
+			monitorVrt(boards[0], refresh_interval, monitor, monitor_passes, results);
+			printf("The monitoring has been completed! \n");
+			return 0;
+		}
 
-void printHelp(char* argv[]){
-	cout << "A sample application that tests retention time of DRAM cells using SoftMC" << endl;
-	cout << "Usage:" << argv[0] << " [REFRESH INTERVAL]" << endl; 
-	cout << "The Refresh Interval should be a positive integer, indicating the target retention time in milliseconds." << endl;
-}
+		if(!patterns.empty()){
+			testPatternSuite(boards[0], refresh_interval, patterns, split, results);
+			printf("The test has been completed! \n");
+			return 0;
+		}
 
-int main(int argc, char* argv[]){
-	fpga_t* fpga;
-	fpga_info_list info;
-	int fid = 0; //fpga id
-	int ch = 0; //channel id
+		printf("Starting Retention Time Test @ %d ms on %d emulated boards! \n", refresh_interval, emulated);
+		testCluster(&cluster, refresh_interval, spread, results);
+		printf("The test has been completed! \n");
 
-	if(argc != 2 || strcmp(argv[1], "--help") == 0){
-		printHelp(argv);
-		return -2;
+		return 0;
 	}
 
-    string s_ref(argv[1]);
-    int refresh_interval = 0;
-
-    try{
-        refresh_interval = stoi(s_ref);    
-    }catch(...){
-        printHelp(argv);
-        return -3;
-    }
-
-    if(refresh_interval <= 0){
-        printHelp(argv);
-        return -4;
-    }
-
 	// Get the list of FPGA's attached to the system
 	if (fpga_list(&info) != 0) {
 		printf("Error populating fpga_info_list\n");
@@ -275,29 +432,136 @@ int main(int argc, char* argv[]){
 		printf("%d: device id:%04X\n", i, info.device_id[i]);
 	}
 
+	if(all_boards){
+		softmc::Cluster* cluster = softmc::Cluster::open();
+
+		if(!cluster){
+			printf("Problem on opening the fpgas \n");
+			return -1;
+		}
+		printf("%u FPGAs have been opened successfully! \n", cluster->size());
+
+		if(db_path && !results.openDbs(db_path, cluster->size())){
+			delete cluster;
+			return -1;
+		}
+
+		printf("Starting Retention Time Test @ %d ms! \n", refresh_interval);
+		testCluster(cluster, refresh_interval, spread, results);
+		printf("The test has been completed! \n");
+
+		delete cluster;
+		return 0;
+	}
+
 	// Open an FPGA device, so we can read/write from/to it
-	fpga = fpga_open(fid);
+	// (this also sends a reset signal, which recovers the FPGA from some unwanted state)
+	RiffaBackend* be = RiffaBackend::open(fid);
 
-	if(!fpga){
+	if(!be){
 		printf("Problem on opening the fpga \n");
 		return -1;
 	}
 	printf("The FPGA has been opened successfully! \n");
+	printf("Instruction channel: %d, read back channel: %d \n", be->chnls.instr, be->chnls.rdback);
 
-	// send a reset signal to the FPGA
-	fpga_reset(fpga); //keep this, recovers FPGA from some unwanted state
+	if(db_path && !results.openDbs(db_path, 1)){
+		delete be;
+		return -1;
+	}
+
+	if(monitor > 0){
+		monitorVrt(be, refresh_interval, monitor, monitor_passes, results);
+		printf("The monitoring has been completed! \n");
+
+		delete be;
+		return 0;
+	}
+
+	if(!patterns.empty()){
+		testPatternSuite(be, refresh_interval, patterns, split, results);
+		printf("The test has been completed! \n");
+
+		delete be;
+		return 0;
+	}
 
 	//uint trefi = 7800/200; //7.8us (divide by 200ns as the HW counts with that period)
 	//uint trfc = 104; //default trfc for 4Gb device
 	//printf("Activating AutoRefresh. tREFI: %d, tRFC: %d \n", trefi, trfc);
-	//setRefreshConfig(fpga, trefi, trfc);
+	//setRefreshConfig(be, trefi, trfc);
+
+	if(profile_min > 0){
+		printf("Profiling retention times between %d and %d ms! \n", profile_min, refresh_interval);
+
+		vector<RowRetention> prof = profileRetention(be, DramAddr(0, 0), NUM_DIMM_ROWS, 0xff,
+				profile_min, refresh_interval, PROFILE_LEVELS, true);
+
+		for(uint i = 0; i < prof.size(); i++){
+			if(prof[i].fail_ms == NO_FAILURE)
+				continue;
+
+			printf("Row: %u, Bank: %u, Retention: %u-%u ms \n", i%NUM_ROWS, i/NUM_ROWS,
+					prof[i].pass_ms, prof[i].fail_ms);
+		}
+
+		printf("The profiling has been completed! \n");
+		delete be;
+		return 0;
+	}
+
+	if(!sweep.empty() && find(sweep.begin(), sweep.end(), refresh_interval) == sweep.end())
+		sweep.push_back(refresh_interval);
+
+	BankMajorOrder major;
+	BankInterleavedOrder interleaved;
+	SubarrayOrder subarray;
+	RandomOrder random(RowRegion(), 1); //fixed seed, so that a resumed sweep forms the same groups
+	const RowOrder& physical = order_name == "interleaved" ? (const RowOrder&)interleaved :
+		order_name == "subarray" ? (const RowOrder&)subarray :
+		order_name == "random" ? (const RowOrder&)random : (const RowOrder&)major;
+	PhysicalOrder physical_order(physical, row_map);
+
+	// rows known to fail at the shortest target fail at the others as well
+	vector<DramAddr> untested;
+	if(skip_weak){
+		int shortest = sweep.empty() ? refresh_interval : *min_element(sweep.begin(), sweep.end());
+		for(uint i = 0; i < physical_order.size(); i++){
+			DramAddr a = physical_order.addr(i);
+			if(results.dbs[0]->rowMinFailure(a) > (uint32_t)shortest)
+				untested.push_back(a);
+		}
+		printf("Skipping %u rows that are known to fail at %d ms \n", physical_order.size() - (uint)untested.size(),
+				shortest);
+	}
+	ListOrder filtered(untested);
+	const RowOrder& order = skip_weak ? (const RowOrder&)filtered : (const RowOrder&)physical_order;
+
+	if(!sweep.empty()){
+		printf("Starting Retention Time Sweep @ %zu retention times! \n", sweep.size());
+
+		vector<SweepStats> stats = sweepRetention(be, sweep, order, 0xff,
+				[&results](int retention, const ReadError& e){ results.add(e, 0, retention); },
+				SWEEP_GROUP_ROWS, true, ckpt);
+
+		for(const SweepStats& st : stats)
+			printf("%d ms: %u row groups, read back late by %.2f ms on average, %.2f ms at most \n",
+					st.retention, st.groups, st.groups ? st.total_late_ms/st.groups : 0.0, st.max_late_ms);
+
+		printf("The test has been completed! \n");
+		delete ckpt;
+		delete be;
+		return 0;
+	}
 
   	printf("Starting Retention Time Test @ %d ms! \n", refresh_interval);
 
-	testRetention(fpga, refresh_interval);
+	testRetention(be, refresh_interval, order, 0xff,
+			[&results](const ReadError& e){ results.add(e, 0); }, true, nullptr, ckpt);
 
 	printf("The test has been completed! \n");
-	fpga_close(fpga);
+	delete ckpt;
+	delete be;
 
 	return 0;
 }
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <riffa.h>
+#include <string.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "softmc.h"
+#include "hammer.h"
+#include "hammersearch.h"
+#include "emulator.h"
+
+using namespace std;
+
+// candidates of the pattern search
+#define SEARCH_MAX_SIDES 4
+#define SEARCH_MAX_BOOST 2
+
+void printHelp(char* argv[]){
+	cout << "A sample application that tests DRAM rows for read disturbance (RowHammer) using SoftMC" << endl;
+	cout << "Usage:" << argv[0] << " [HAMMERS] [--single | --double | --many N] [--bank B] [--row R] [--rows N] [--search] [--emulate]" << endl;
+	cout << "HAMMERS is the number of times every aggressor row is activated." << endl;
+	cout << "--single hammers each row and checks both of its neighbours, --double (default) hammers both neighbours of each" << endl;
+	cout << " victim row and --many N hammers N aggressors two rows apart." << endl;
+	cout << "--bank B, --row R and --rows N select the victim rows to test (bank 0, rows 1-64 by default)." << endl;
+	cout << "--search ranks aggressor patterns of up to N sides (--many N, 4 by default) with different spacings, orders" << endl;
+	cout << " and intensities by bit flips per ACT. The selected rows are tested in every bank." << endl;
+	cout << "--emulate tests an emulated board instead of a real one." << endl;
+}
+
+int main(int argc, char* argv[]){
+	if(argc < 2 || strcmp(argv[1], "--help") == 0){
+		printHelp(argv);
+		return -2;
+	}
+
+	int hammers = 0;
+	try{
+		hammers = stoi(string(argv[1]));
+	}catch(...){
+		printHelp(argv);
+		return -3;
+	}
+
+	int sides = 2;
+	uint bank = 0, first_row = 1, num_rows = 64;
+	bool emulate = false, search = false, many = false;
+
+	for(int i = 2; i < argc; i++){
+		if(strcmp(argv[i], "--single") == 0)
+			sides = 1;
+		else if(strcmp(argv[i], "--double") == 0)
+			sides = 2;
+		else if(strcmp(argv[i], "--many") == 0 && i + 1 < argc){
+			sides = atoi(argv[++i]);
+			many = true;
+		}
+		else if(strcmp(argv[i], "--bank") == 0 && i + 1 < argc)
+			bank = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--row") == 0 && i + 1 < argc)
+			first_row = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--rows") == 0 && i + 1 < argc)
+			num_rows = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--search") == 0)
+			search = true;
+		else if(strcmp(argv[i], "--emulate") == 0)
+			emulate = true;
+		else{
+			printHelp(argv);
+			return -2;
+		}
+	}
+
+	if(hammers <= 0 || sides < 1 || bank >= NUM_BANKS || first_row >= NUM_ROWS){
+		printHelp(argv);
+		return -4;
+	}
+
+	Backend* be;
+	if(emulate)
+		be = new EmulatorBackend();
+	else{
+		// Open an FPGA device, so we can read/write from/to it
+		// (this also sends a reset signal, which recovers the FPGA from some unwanted state)
+		be = RiffaBackend::open(0);
+
+		if(!be){
+			printf("Problem on opening the fpga \n");
+			return -1;
+		}
+		printf("The FPGA has been opened successfully! \n");
+	}
+
+	if(search){
+		vector<uint> max_sides;
+		for(int s = 1; s <= (many ? sides : SEARCH_MAX_SIDES); s++)
+			max_sides.push_back(s);
+		vector<HammerCandidate> candidates = hammerCandidates(max_sides, {1, 2, 3}, SEARCH_MAX_BOOST);
+
+		// place the candidates next to each other, far enough apart not to overlap
+		uint stride = 0;
+		for(const HammerCandidate& c : candidates)
+			stride = max(stride, c.span());
+
+		vector<DramAddr> places;
+		for(uint b = 0; b < NUM_BANKS; b++)
+			for(uint r = first_row; r < first_row + num_rows && r + stride <= NUM_ROWS; r += stride)
+				places.push_back(DramAddr(r, b));
+
+		printf("Searching %zu aggressor patterns at %zu places with %d hammers! \n", candidates.size(),
+				places.size(), hammers);
+
+		vector<HammerScore> scores = searchHammerPatterns(be, candidates, places, hammers, 0xff, 0x00,
+				nullptr, true);
+
+		printf("%-48s %8s %12s %10s \n", "Pattern", "Flipped", "Flips", "Flips/MACT");
+		for(const HammerScore& s : scores)
+			printf("%-48s %4u/%-3u %12llu %10.3f \n", s.candidate.name().c_str(), s.flipped, s.tests,
+					(unsigned long long)s.flips, s.rate());
+
+		printf("The test has been completed! \n");
+
+		delete be;
+		return 0;
+	}
+
+	printf("Starting %d-sided RowHammer Test with %d hammers per aggressor! \n", sides, hammers);
+
+	// patterns of more than one aggressor cover two rows per aggressor
+	uint step = sides > 2 ? 2*(sides - 1) : 1;
+	uint64_t acts = 0;
+	double hammer_ms = 0;
+	uint tests = 0, flipped = 0;
+
+	for(uint r = first_row; r < first_row + num_rows && r < NUM_ROWS; r += step){
+		HammerPattern p = sides == 1 ? HammerPattern::singleSided(bank, r) :
+			sides == 2 ? HammerPattern::doubleSided(bank, r) :
+			HammerPattern::manySided(bank, r, sides);
+
+		HammerResult res = testHammer(be, p, hammers, 0xff, 0x00, printError);
+
+		acts += res.acts;
+		hammer_ms += res.hammer_ms;
+		tests++;
+		if(res.errors)
+			flipped++;
+	}
+
+	printf("%u patterns tested, %u with bit flips. %llu ACTs in %.1f ms (%.1f M ACT/s) \n", tests, flipped,
+			(unsigned long long)acts, hammer_ms, hammer_ms > 0 ? acts/hammer_ms/1000.0 : 0.0);
+	printf("The test has been completed! \n");
+
+	delete be;
+	return 0;
+}
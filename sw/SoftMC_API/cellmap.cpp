@@ -0,0 +1,372 @@
+#include "cellmap.h"
+#include <algorithm>
+#include <iterator>
+#include <sys/stat.h>
+
+using namespace std;
+
+CellBitmap::CellBitmap(){
+	last = 0;
+}
+
+uint64_t CellBitmap::cellIndex(const DramAddr& addr, uint col, uint lane, uint bit){
+	uint64_t row = (uint64_t)addr.bank*NUM_ROWS + addr.row;
+	return (row*NUM_COLS + col)*BITS_PER_COL + lane*8 + bit;
+}
+
+void CellBitmap::cellAddr(uint64_t idx, DramAddr& addr, uint& col, uint& lane, uint& bit){
+	bit = idx % 8;
+	lane = (idx / 8) % 8;
+	col = (idx / BITS_PER_COL) % NUM_COLS;
+
+	uint64_t row = idx / BITS_PER_COL / NUM_COLS;
+	addr = DramAddr(row % NUM_ROWS, row / NUM_ROWS);
+}
+
+void CellBitmap::Container::insert(uint16_t low){
+	if(isBitmap()){
+		uint64_t m = 1ULL << (low % 64);
+		if(!(bits[low/64] & m)){
+			bits[low/64] |= m;
+			card++;
+		}
+		return;
+	}
+
+	auto it = lower_bound(array.begin(), array.end(), low);
+	if(it != array.end() && *it == low)
+		return;
+
+	if(card < ARRAY_MAX){
+		array.insert(it, low);
+		card++;
+		return;
+	}
+
+	toBitmap();
+	insert(low);
+}
+
+bool CellBitmap::Container::contains(uint16_t low) const{
+	if(isBitmap())
+		return bits[low/64] & (1ULL << (low % 64));
+
+	return binary_search(array.begin(), array.end(), low);
+}
+
+void CellBitmap::Container::toBitmap(){
+	bits.assign(BITMAP_WORDS, 0);
+	for(uint16_t low : array)
+		bits[low/64] |= 1ULL << (low % 64);
+
+	vector<uint16_t>().swap(array);
+}
+
+void CellBitmap::Container::toArray(){
+	array.clear();
+	array.reserve(card);
+	for(uint w = 0; w < BITMAP_WORDS; w++){
+		uint64_t word = bits[w];
+		while(word){
+			array.push_back(w*64 + __builtin_ctzll(word));
+			word &= word - 1;
+		}
+	}
+
+	vector<uint64_t>().swap(bits);
+}
+
+void CellBitmap::Container::shrink(){
+	if(isBitmap() && card <= ARRAY_MAX)
+		toArray();
+}
+
+CellBitmap::Container* CellBitmap::find(uint32_t key){
+	return const_cast<Container*>(static_cast<const CellBitmap*>(this)->find(key));
+}
+
+const CellBitmap::Container* CellBitmap::find(uint32_t key) const{
+	if(last < containers.size() && containers[last].key == key)
+		return &containers[last];
+
+	auto it = lower_bound(containers.begin(), containers.end(), key,
+			[](const Container& c, uint32_t k){ return c.key < k; });
+
+	if(it == containers.end() || it->key != key)
+		return nullptr;
+
+	return &*it;
+}
+
+CellBitmap::Container& CellBitmap::findOrCreate(uint32_t key){
+	// the compare kernel reports the errors of a row one after the other
+	if(last < containers.size() && containers[last].key == key)
+		return containers[last];
+
+	auto it = lower_bound(containers.begin(), containers.end(), key,
+			[](const Container& c, uint32_t k){ return c.key < k; });
+
+	if(it == containers.end() || it->key != key)
+		it = containers.insert(it, Container(key));
+
+	last = it - containers.begin();
+	return *it;
+}
+
+void CellBitmap::insert(uint64_t idx){
+	findOrCreate(idx >> 16).insert(idx & 0xFFFF);
+}
+
+void CellBitmap::insert(const ReadError& err){
+	uint8_t diff = err.data ^ err.expected;
+	if(!diff)
+		return;
+
+	uint64_t base = cellIndex(DramAddr(err.row, err.bank), err.col, err.lane, 0);
+	Container& c = findOrCreate(base >> 16);
+
+	for(uint b = 0; b < 8; b++)
+		if(diff & (1 << b))
+			c.insert((base + b) & 0xFFFF);
+}
+
+bool CellBitmap::contains(uint64_t idx) const{
+	const Container* c = find(idx >> 16);
+	return c && c->contains(idx & 0xFFFF);
+}
+
+uint64_t CellBitmap::cardinality() const{
+	uint64_t n = 0;
+	for(const Container& c : containers)
+		n += c.card;
+
+	return n;
+}
+
+static uint popcount(const vector<uint64_t>& bits){
+	uint n = 0;
+	for(uint64_t w : bits)
+		n += __builtin_popcountll(w);
+
+	return n;
+}
+
+void CellBitmap::unionWith(Container& a, const Container& b){
+	if(!a.isBitmap() && !b.isBitmap()){
+		vector<uint16_t> out;
+		out.reserve(a.card + b.card);
+		set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), back_inserter(out));
+
+		a.array.swap(out);
+		a.card = a.array.size();
+		if(a.card > ARRAY_MAX)
+			a.toBitmap();
+		return;
+	}
+
+	if(!a.isBitmap())
+		a.toBitmap();
+
+	if(b.isBitmap()){
+		for(uint w = 0; w < BITMAP_WORDS; w++)
+			a.bits[w] |= b.bits[w];
+	}
+	else{
+		for(uint16_t low : b.array)
+			a.bits[low/64] |= 1ULL << (low % 64);
+	}
+
+	a.card = popcount(a.bits);
+}
+
+void CellBitmap::intersectWith(Container& a, const Container& b){
+	if(!a.isBitmap()){
+		vector<uint16_t> out;
+		for(uint16_t low : a.array)
+			if(b.contains(low))
+				out.push_back(low);
+
+		a.array.swap(out);
+		a.card = a.array.size();
+		return;
+	}
+
+	if(!b.isBitmap()){
+		vector<uint16_t> out;
+		for(uint16_t low : b.array)
+			if(a.contains(low))
+				out.push_back(low);
+
+		vector<uint64_t>().swap(a.bits);
+		a.array.swap(out);
+		a.card = a.array.size();
+		return;
+	}
+
+	for(uint w = 0; w < BITMAP_WORDS; w++)
+		a.bits[w] &= b.bits[w];
+
+	a.card = popcount(a.bits);
+	a.shrink();
+}
+
+void CellBitmap::subtract(Container& a, const Container& b){
+	if(!a.isBitmap()){
+		vector<uint16_t> out;
+		for(uint16_t low : a.array)
+			if(!b.contains(low))
+				out.push_back(low);
+
+		a.array.swap(out);
+		a.card = a.array.size();
+		return;
+	}
+
+	if(b.isBitmap()){
+		for(uint w = 0; w < BITMAP_WORDS; w++)
+			a.bits[w] &= ~b.bits[w];
+	}
+	else{
+		for(uint16_t low : b.array)
+			a.bits[low/64] &= ~(1ULL << (low % 64));
+	}
+
+	a.card = popcount(a.bits);
+	a.shrink();
+}
+
+CellBitmap& CellBitmap::operator|=(const CellBitmap& other){
+	vector<Container> out;
+	out.reserve(containers.size() + other.containers.size());
+
+	auto a = containers.begin();
+	auto b = other.containers.begin();
+	while(a != containers.end() || b != other.containers.end()){
+		if(b == other.containers.end() || (a != containers.end() && a->key < b->key))
+			out.push_back(move(*a++));
+		else if(a == containers.end() || b->key < a->key)
+			out.push_back(*b++);
+		else{
+			unionWith(*a, *b++);
+			out.push_back(move(*a++));
+		}
+	}
+
+	containers.swap(out);
+	last = 0;
+	return *this;
+}
+
+CellBitmap& CellBitmap::operator&=(const CellBitmap& other){
+	vector<Container> out;
+
+	auto b = other.containers.begin();
+	for(Container& a : containers){
+		while(b != other.containers.end() && b->key < a.key)
+			b++;
+
+		if(b == other.containers.end())
+			break;
+		if(b->key != a.key)
+			continue;
+
+		intersectWith(a, *b);
+		if(a.card)
+			out.push_back(move(a));
+	}
+
+	containers.swap(out);
+	last = 0;
+	return *this;
+}
+
+CellBitmap& CellBitmap::operator-=(const CellBitmap& other){
+	vector<Container> out;
+
+	auto b = other.containers.begin();
+	for(Container& a : containers){
+		while(b != other.containers.end() && b->key < a.key)
+			b++;
+
+		if(b != other.containers.end() && b->key == a.key)
+			subtract(a, *b);
+
+		if(a.card)
+			out.push_back(move(a));
+	}
+
+	containers.swap(out);
+	last = 0;
+	return *this;
+}
+
+//! Serializes the bitmap. Containers with more than ARRAY_MAX cells are
+//written as 8 KiB bitmaps, the others as sorted arrays.
+bool CellBitmap::write(FILE* f) const{
+	uint64_t hdr[2] = {CELLMAP_MAGIC, containers.size()};
+	if(fwrite(hdr, sizeof(hdr), 1, f) != 1)
+		return false;
+
+	for(const Container& c : containers){
+		uint32_t kc[2] = {c.key, c.card};
+		if(fwrite(kc, sizeof(kc), 1, f) != 1)
+			return false;
+
+		bool ok = c.isBitmap() ?
+			fwrite(c.bits.data(), sizeof(uint64_t), BITMAP_WORDS, f) == BITMAP_WORDS :
+			fwrite(c.array.data(), sizeof(uint16_t), c.card, f) == c.card;
+		if(!ok)
+			return false;
+	}
+
+	return true;
+}
+
+bool CellBitmap::read(FILE* f){
+	clear();
+
+	uint64_t hdr[2];
+	if(fread(hdr, sizeof(hdr), 1, f) != 1 || hdr[0] != CELLMAP_MAGIC)
+		return false;
+
+	// the count is checked before anything is allocated for it: there is a
+	//container per 65536 cells at most, and each takes at least its key and
+	//cardinality in the file
+	const uint64_t max_containers = ((uint64_t)NUM_BANKS*NUM_ROWS*NUM_COLS*BITS_PER_COL + 65535) >> 16;
+	struct stat st;
+	long pos = ftell(f);
+	if(hdr[1] > max_containers || (pos >= 0 && fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode) &&
+			hdr[1]*2*sizeof(uint32_t) > (uint64_t)max((off_t)0, st.st_size - pos)))
+		return false;
+
+	containers.reserve(hdr[1]);
+	for(uint64_t i = 0; i < hdr[1]; i++){
+		uint32_t kc[2];
+		if(fread(kc, sizeof(kc), 1, f) != 1 || kc[0] >= max_containers || kc[1] > 65536 ||
+				(!containers.empty() && containers.back().key >= kc[0])){
+			clear();
+			return false;
+		}
+
+		containers.push_back(Container(kc[0]));
+		Container& c = containers.back();
+		c.card = kc[1];
+
+		bool ok;
+		if(c.card > ARRAY_MAX){
+			c.bits.resize(BITMAP_WORDS);
+			ok = fread(c.bits.data(), sizeof(uint64_t), BITMAP_WORDS, f) == BITMAP_WORDS;
+		}
+		else{
+			c.array.resize(c.card);
+			ok = fread(c.array.data(), sizeof(uint16_t), c.card, f) == c.card;
+		}
+
+		if(!ok){
+			clear();
+			return false;
+		}
+	}
+
+	return true;
+}
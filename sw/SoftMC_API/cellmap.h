@@ -0,0 +1,104 @@
+#ifndef CELLMAP_H
+#define CELLMAP_H
+
+#include <stdio.h>
+#include <vector>
+#include "rowops.h"
+
+// bits stored at each column address (8 byte lanes of the 64-bit bus)
+#define BITS_PER_COL 64
+#define CELLMAP_MAGIC 0x3150414D4C4C4543ULL //"CELLMAP1"
+
+//! Compressed bitmap of DRAM cells, e.g. the cells that failed in a run.
+/*!
+  Cells are numbered linearly, bank major:
+  ((bank*NUM_ROWS + row)*NUM_COLS + col)*BITS_PER_COL + lane*8 + bit,
+  which makes 2^34 cells for a 4Gb x8 rank. As in roaring bitmaps, the upper
+  bits of the index select a container (here exactly one DRAM row) and the
+  lower 16 bits are kept either as a sorted array, while the container is
+  sparse, or as a 64 Kbit bitmap once it has more than ARRAY_MAX cells.
+*/
+class CellBitmap{
+
+	public:
+		CellBitmap();
+
+		static uint64_t cellIndex(const DramAddr& addr, uint col, uint lane, uint bit);
+		static void cellAddr(uint64_t idx, DramAddr& addr, uint& col, uint& lane, uint& bit);
+
+		void insert(uint64_t idx);
+		void insert(const ReadError& err); //every bit in which data and expected differ
+		bool contains(uint64_t idx) const;
+
+		uint64_t cardinality() const;
+		bool empty() const { return containers.empty(); }
+		void clear() { containers.clear(); last = 0; }
+
+		CellBitmap& operator|=(const CellBitmap& other);
+		CellBitmap& operator&=(const CellBitmap& other);
+		CellBitmap& operator-=(const CellBitmap& other);
+
+		bool write(FILE* f) const;
+		bool read(FILE* f);
+
+		template<typename F>
+		void forEach(F f) const;
+
+	private:
+		const static uint ARRAY_MAX = 4096;
+		const static uint BITMAP_WORDS = 65536/64;
+
+		class Container{
+
+			public:
+				uint32_t key;
+				uint32_t card;
+				std::vector<uint16_t> array; //sorted, used while bits is empty
+				std::vector<uint64_t> bits;
+
+				Container(uint32_t key) { this->key = key; card = 0; }
+
+				bool isBitmap() const { return !bits.empty(); }
+				void insert(uint16_t low);
+				bool contains(uint16_t low) const;
+				void toBitmap();
+				void toArray();
+				void shrink(); //converts a bitmap back to an array when it gets sparse
+		};
+
+		Container* find(uint32_t key);
+		const Container* find(uint32_t key) const;
+		Container& findOrCreate(uint32_t key);
+
+		static void unionWith(Container& a, const Container& b);
+		static void intersectWith(Container& a, const Container& b);
+		static void subtract(Container& a, const Container& b);
+
+		std::vector<Container> containers; //sorted by key
+		size_t last; //position of the last accessed container
+};
+
+//! Calls f with the index of every cell in the bitmap, in increasing order.
+template<typename F>
+void CellBitmap::forEach(F f) const{
+	for(const Container& c : containers){
+		uint64_t high = (uint64_t)c.key << 16;
+
+		if(!c.isBitmap()){
+			for(uint16_t low : c.array)
+				f(high | low);
+			continue;
+		}
+
+		for(uint w = 0; w < BITMAP_WORDS; w++){
+			uint64_t word = c.bits[w];
+			while(word){
+				uint b = __builtin_ctzll(word);
+				f(high | (w*64 + b));
+				word &= word - 1;
+			}
+		}
+	}
+}
+
+#endif //CELLMAP_H
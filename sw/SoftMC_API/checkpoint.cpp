@@ -0,0 +1,231 @@
+#include "checkpoint.h"
+#include "scheduler.h"
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+#define CHECKPOINT_MAGIC 0x32544E50484B4353ULL //"SCKHPNT2"
+
+//! Header of a journal block, followed by the ranges and the output sizes.
+class BlockHeader{
+
+	public:
+		uint32_t num_ranges;
+		uint32_t num_outputs;
+};
+
+static uint64_t fileSize(const string& path){
+	struct stat st;
+	return stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+Checkpoint::Checkpoint(){
+	interval = CHECKPOINT_INTERVAL;
+	file = nullptr;
+	last_sync = 0;
+}
+
+Checkpoint::~Checkpoint(){
+	close();
+}
+
+//! Loads the journal, or starts a new one if it is missing or has another key.
+/*!
+  The outputs of a loaded journal are cut back to the sizes of its last
+ complete block.
+*/
+bool Checkpoint::open(const char* path, const string& key){
+	close();
+
+	FILE* f = fopen(path, "rb");
+	long valid = 0;
+	vector<uint64_t> sizes;
+	if(f){
+		uint64_t magic = 0;
+		uint32_t len = 0;
+		string k;
+
+		if(fread(&magic, sizeof(magic), 1, f) == 1 && magic == CHECKPOINT_MAGIC &&
+				fread(&len, sizeof(len), 1, f) == 1 && len == key.size()){
+			k.resize(len);
+			if(fread(&k[0], 1, len, f) != len)
+				k.clear();
+		}
+
+		if(k == key){
+			valid = ftell(f);
+
+			// a torn block is ignored
+			BlockHeader b;
+			while(fread(&b, sizeof(b), 1, f) == 1){
+				vector<Range> ranges(b.num_ranges);
+				vector<uint64_t> s(b.num_outputs);
+
+				if(fread(ranges.data(), sizeof(Range), ranges.size(), f) != ranges.size() ||
+						fread(s.data(), sizeof(uint64_t), s.size(), f) != s.size())
+					break;
+
+				for(const Range& r : ranges)
+					add(r);
+				sizes = s;
+				valid = ftell(f);
+			}
+		}
+		fclose(f);
+	}
+
+	for(uint i = 0; i < sizes.size() && i < outputs.size(); i++){
+		if(fileSize(outputs[i]) > sizes[i] && truncate(outputs[i].c_str(), sizes[i]) != 0)
+			return false;
+	}
+
+	file = fopen(path, valid ? "r+b" : "wb");
+	if(!file)
+		return false;
+
+	if(valid){
+		// drop a torn block
+		if(ftruncate(fileno(file), valid) != 0)
+			return false;
+		fseek(file, valid, SEEK_SET);
+	}
+	else{
+		uint64_t magic = CHECKPOINT_MAGIC;
+		uint32_t len = key.size();
+		fwrite(&magic, sizeof(magic), 1, file);
+		fwrite(&len, sizeof(len), 1, file);
+		fwrite(key.data(), 1, len, file);
+
+		// results appended before the first sync are cut back to here
+		if(!writeBlock(nullptr, 0))
+			return false;
+	}
+
+	last_sync = DeadlineScheduler::now();
+	return true;
+}
+
+void Checkpoint::close(){
+	if(!file)
+		return;
+
+	sync();
+	fclose(file);
+	file = nullptr;
+
+	done.clear();
+}
+
+//! Merges the range into the completed ranges of its retention time.
+void Checkpoint::add(const Range& r){
+	if(r.row_begin >= r.row_end)
+		return;
+
+	map<uint32_t, uint32_t>& m = done[r.retention];
+	uint32_t begin = r.row_begin, end = r.row_end;
+
+	auto it = m.upper_bound(begin);
+	if(it != m.begin() && prev(it)->second >= begin){
+		it--;
+		begin = it->first;
+		if(it->second > end)
+			end = it->second;
+	}
+
+	while(it != m.end() && it->first <= end){
+		if(it->second > end)
+			end = it->second;
+		it = m.erase(it);
+	}
+
+	m[begin] = end;
+}
+
+bool Checkpoint::isDone(int retention, uint32_t row) const{
+	auto d = done.find(retention);
+	if(d == done.end())
+		return false;
+
+	auto it = d->second.upper_bound(row);
+	return it != d->second.begin() && prev(it)->second > row;
+}
+
+//! Returns the first row from \e row on that has not been completed.
+uint32_t Checkpoint::nextUndone(int retention, uint32_t row) const{
+	auto d = done.find(retention);
+	if(d == done.end())
+		return row;
+
+	auto it = d->second.upper_bound(row);
+	if(it != d->second.begin() && prev(it)->second > row)
+		return prev(it)->second;
+
+	return row;
+}
+
+uint64_t Checkpoint::doneRows(int retention) const{
+	auto d = done.find(retention);
+	if(d == done.end())
+		return 0;
+
+	uint64_t n = 0;
+	for(const auto& r : d->second)
+		n += r.second - r.first;
+
+	return n;
+}
+
+//! Marks the rows as completed. Writes the journal if \e interval has passed.
+void Checkpoint::complete(int retention, const uint32_t* rows, uint32_t num_rows){
+	for(uint32_t i = 0; i < num_rows;){
+		Range r;
+		r.retention = retention;
+		r.row_begin = rows[i];
+		r.row_end = rows[i] + 1;
+
+		for(i++; i < num_rows && rows[i] == r.row_end; i++)
+			r.row_end++;
+
+		add(r);
+		pending.push_back(r);
+	}
+
+	if(DeadlineScheduler::now() - last_sync >= interval*1e9)
+		sync();
+}
+
+//! Makes the results durable and appends the completed ranges to the journal.
+bool Checkpoint::sync(){
+	last_sync = DeadlineScheduler::now();
+
+	if(!file || pending.empty())
+		return file != nullptr;
+
+	if(before_sync)
+		before_sync();
+
+	bool ok = writeBlock(pending.data(), pending.size());
+	pending.clear();
+
+	return ok;
+}
+
+//! Appends the ranges and the current sizes of the outputs to the journal.
+bool Checkpoint::writeBlock(const Range* ranges, uint32_t num_ranges){
+	BlockHeader b;
+	b.num_ranges = num_ranges;
+	b.num_outputs = outputs.size();
+
+	vector<uint64_t> sizes;
+	for(const string& o : outputs)
+		sizes.push_back(fileSize(o));
+
+	bool ok = fwrite(&b, sizeof(b), 1, file) == 1;
+	ok = ok && fwrite(ranges, sizeof(Range), num_ranges, file) == num_ranges;
+	ok = ok && fwrite(sizes.data(), sizeof(uint64_t), sizes.size(), file) == sizes.size();
+	ok = (fflush(file) == 0) && ok;
+
+	return ok;
+}
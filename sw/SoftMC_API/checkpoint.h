@@ -0,0 +1,67 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// seconds between two journal writes
+#define CHECKPOINT_INTERVAL 5.0
+
+//! Journal of the rows a long test has completed, so it can be resumed.
+/*!
+  The tests report every row group after its rows have been read back and
+ their errors have gone to the sink. The completed row ranges are buffered
+ and appended to the journal at most every \e interval seconds, after
+ \e before_sync has made the results durable (e.g. flushed the error log),
+ together with the sizes of the \e outputs the results are appended to.
+ Groups in flight when the process dies, or the board is reset, are not in
+ the journal and are tested again, and opening the journal cuts the outputs
+ back to their journaled sizes, so the results of those groups that already
+ reached the files are not counted twice.
+
+  The journal starts with a key that describes the test (retention times,
+ rows, pattern, ...); opening it with a different key starts over.
+*/
+class Checkpoint{
+
+	public:
+		Checkpoint();
+		virtual ~Checkpoint();
+
+		bool open(const char* path, const std::string& key);
+		void close();
+
+		bool isDone(int retention, uint32_t row) const;
+		uint32_t nextUndone(int retention, uint32_t row) const;
+		uint64_t doneRows(int retention) const;
+
+		void complete(int retention, const uint32_t* rows, uint32_t num_rows);
+		bool sync();
+
+		double interval; //seconds
+		std::function<void()> before_sync;
+		std::vector<std::string> outputs; //append-only result files, set before open()
+
+	private:
+		class Range{
+
+			public:
+				int32_t retention;
+				uint32_t row_begin;
+				uint32_t row_end;
+		};
+
+		void add(const Range& r);
+		bool writeBlock(const Range* ranges, uint32_t num_ranges);
+
+		FILE* file;
+		std::map<int, std::map<uint32_t, uint32_t>> done; //retention -> row_begin -> row_end
+		std::vector<Range> pending;
+		uint64_t last_sync; //DeadlineScheduler::now() time
+};
+
+#endif //CHECKPOINT_H
@@ -0,0 +1,168 @@
+#include "cluster.h"
+#include <algorithm>
+#include <thread>
+
+using namespace std;
+
+namespace softmc{
+
+//! Creates a cluster of the given boards. The cluster takes ownership of
+//the boards. The index of a board is the DIMM id used by the shards.
+Cluster::Cluster(const vector<Backend*>& boards){
+	this->boards = boards;
+
+	for(uint i = 0; i < boards.size(); i++)
+		queues.push_back(new WorkQueue);
+}
+
+Cluster::~Cluster(){
+	for(uint i = 0; i < boards.size(); i++){
+		delete boards[i];
+		delete queues[i];
+	}
+}
+
+//! Opens every board listed by fpga_list.
+/*!
+  \return The cluster, or nullptr if the boards could not be listed or
+ none of them could be opened.
+*/
+Cluster* Cluster::open(){
+	fpga_info_list info;
+
+	if(fpga_list(&info) != 0)
+		return nullptr;
+
+	vector<Backend*> boards;
+	for(int i = 0; i < info.num_fpgas; i++){
+		RiffaBackend* be = RiffaBackend::open(info.id[i]);
+
+		if(be)
+			boards.push_back(be);
+	}
+
+	if(boards.empty())
+		return nullptr;
+
+	return new Cluster(boards);
+}
+
+//! Splits an entire DIMM into shards of the given number of rows.
+/*!
+  \param \e dimm is the DIMM the shards are pinned to, or ANY_DIMM.
+  \param \e rows_per_shard is the number of rows in each shard. Shards do
+ not cross bank boundaries.
+*/
+vector<Shard> Cluster::split(int dimm, uint rows_per_shard){
+	vector<Shard> shards;
+
+	for(uint b = 0; b < NUM_BANKS; b++)
+		for(uint r = 0; r < NUM_ROWS; r += rows_per_shard)
+			shards.push_back(Shard(dimm, b, r, min(r + rows_per_shard, (uint)NUM_ROWS)));
+
+	return shards;
+}
+
+//! Picks the next shard for the given board. Returns false when no work is
+//left for it.
+bool Cluster::next(uint dimm, Shard& shard){
+	WorkQueue* own = queues[dimm];
+	{
+		lock_guard<mutex> lock(own->lock);
+
+		if(!own->pinned.empty()){
+			shard = own->pinned.front();
+			own->pinned.pop_front();
+			return true;
+		}
+
+		if(!own->shared.empty()){
+			shard = own->shared.front();
+			own->shared.pop_front();
+			return true;
+		}
+	}
+
+	// steal from the back of the queue with the most shared shards, again
+	//if another board emptied it in the meantime
+	while(true){
+		WorkQueue* victim = nullptr;
+		size_t most = 0;
+
+		for(uint i = 1; i < queues.size(); i++){
+			WorkQueue* q = queues[(dimm + i) % queues.size()];
+			lock_guard<mutex> lock(q->lock);
+
+			if(q->shared.size() > most){
+				victim = q;
+				most = q->shared.size();
+			}
+		}
+
+		if(!victim)
+			return false;
+
+		lock_guard<mutex> lock(victim->lock);
+		if(!victim->shared.empty()){
+			shard = victim->shared.back();
+			victim->shared.pop_back();
+			return true;
+		}
+	}
+}
+
+//! Runs the test plan on every shard and waits for all boards to finish.
+/*!
+  \param \e plan is called once per shard, on the worker thread of the
+ board that runs it.
+  \param \e shards are the shards to run. Shards pinned to a DIMM that is
+ not part of the cluster are skipped.
+  \param \e sink receives the errors of every shard when it is done, sorted
+ by bank, row, column and byte lane, with the DIMM of the board that ran
+ it. It is called from one worker thread at a time.
+*/
+void Cluster::run(const TestPlan& plan, const vector<Shard>& shards, const ClusterSink& sink){
+	uint next_shared = 0;
+
+	for(const Shard& s : shards){
+		if(s.dimm == ANY_DIMM){
+			queues[next_shared]->shared.push_back(s);
+			next_shared = (next_shared + 1) % queues.size();
+		}
+		else if(s.dimm >= 0 && (uint)s.dimm < queues.size())
+			queues[s.dimm]->pinned.push_back(s);
+	}
+
+	mutex sink_lock;
+	vector<thread> workers;
+
+	for(uint d = 0; d < boards.size(); d++){
+		workers.push_back(thread([this, d, &plan, &sink, &sink_lock](){
+			// only the errors of the current shard are kept
+			vector<ReadError> errors;
+			ErrorSink collect = [&errors](const ReadError& err){ errors.push_back(err); };
+			Shard s;
+
+			while(next(d, s)){
+				plan(boards[d], s, collect);
+
+				sort(errors.begin(), errors.end(), [](const ReadError& a, const ReadError& b){
+					if(a.bank != b.bank) return a.bank < b.bank;
+					if(a.row != b.row) return a.row < b.row;
+					if(a.col != b.col) return a.col < b.col;
+					return a.lane < b.lane;
+				});
+
+				lock_guard<mutex> l(sink_lock);
+				for(const ReadError& e : errors)
+					sink(d, e);
+				errors.clear();
+			}
+		}));
+	}
+
+	for(thread& w : workers)
+		w.join();
+}
+
+} //namespace softmc
@@ -0,0 +1,77 @@
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "rowops.h"
+
+namespace softmc{
+
+#define ANY_DIMM -1
+
+//! A slice of a test plan: rows [row_begin, row_end) of one bank.
+/*!
+  A shard pinned to a DIMM runs on the board that holds it. Shards with
+  \e dimm set to ANY_DIMM can run on any board and are stolen by idle
+  boards.
+*/
+class Shard{
+
+	public:
+		int dimm;
+		uint bank;
+		uint row_begin;
+		uint row_end;
+
+		Shard() : Shard(ANY_DIMM, 0, 0, 0){}
+		Shard(int dimm, uint bank, uint row_begin, uint row_end){
+			this->dimm = dimm; this->bank = bank; this->row_begin = row_begin; this->row_end = row_end;
+		}
+};
+
+//! Runs a shard on a board and reports the errors to the sink.
+typedef std::function<void(Backend* be, const Shard& shard, const ErrorSink& sink)> TestPlan;
+
+//! Receives the errors of the boards of a Cluster, one shard at a time.
+typedef std::function<void(int dimm, const ReadError& err)> ClusterSink;
+
+//! Runs a test plan over several SoftMC boards at the same time.
+/*!
+  Each board is driven by its own worker thread. Pinned shards are queued
+  to the board of their DIMM. Unpinned shards are spread over all boards
+  and an idle board steals them from the back of the busiest queues. The
+  errors of a shard are sorted and passed to the sink as soon as the shard
+  is done, one shard at a time.
+*/
+class Cluster{
+
+	public:
+		Cluster(const std::vector<Backend*>& boards);
+		virtual ~Cluster();
+
+		static Cluster* open();
+		static std::vector<Shard> split(int dimm, uint rows_per_shard);
+
+		uint size() const { return boards.size(); }
+		Backend* board(uint dimm) { return boards[dimm]; }
+
+		void run(const TestPlan& plan, const std::vector<Shard>& shards, const ClusterSink& sink);
+
+	private:
+		struct WorkQueue{
+			std::mutex lock;
+			std::deque<Shard> pinned;
+			std::deque<Shard> shared;
+		};
+
+		bool next(uint dimm, Shard& shard);
+
+		std::vector<Backend*> boards;
+		std::vector<WorkQueue*> queues;
+};
+
+} //namespace softmc
+
+#endif //CLUSTER_H
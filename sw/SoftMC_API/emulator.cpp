@@ -0,0 +1,444 @@
+#include "emulator.h"
+#include "splitmix.h"
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+using namespace std;
+
+// cycles from a WR or RD with auto-precharge to its internal PRE: CWL (5),
+//the burst (4) and tWR (6) after a WR, tRTP (4) after a RD, and at least
+//tRAS (14) after the ACT
+#define AP_WR_CYCLES 15
+#define AP_RD_CYCLES 4
+#define AP_TRAS_CYCLES 14
+
+// rows refreshed in every bank by a single REF command
+#define ROWS_PER_REF (NUM_ROWS/REFS_PER_WINDOW)
+
+EmulatorBackend::EmulatorBackend(uint64_t seed){
+	this->seed = seed;
+	weak_row_ratio = 0.01;
+	min_retention_ms = 100.0;
+	max_retention_ms = 20000.0;
+	vrt_ratio = 0.2;
+	vrt_period_ms = 10000.0;
+	hammer_row_ratio = 0.05;
+	min_hammer_acts = 20000;
+	max_hammer_acts = 400000;
+	min_trcd_cycles = 3;
+	max_trcd_cycles = 6;
+	min_trp_cycles = 3;
+	max_trp_cycles = 6;
+	min_tras_cycles = 8;
+	max_tras_cycles = 14;
+	min_twr_cycles = 10;
+	max_twr_cycles = 14;
+	min_trtp_cycles = 2;
+	max_trtp_cycles = 4;
+
+	// the emulator always exposes separate instruction and read back channels
+	chnls = ChannelMap(INSTR_CHNL, RDBACK_CHNL);
+
+	for(int i = 0; i < NUM_BANKS; i++){
+		open_row[i] = -1;
+		act_cycle[i] = 0;
+		pre_cycle[i] = 0;
+	}
+
+	created = Clock::now();
+	cycle = 1024; //as if the banks had been precharged long ago
+	ref_ptr = 0;
+	trefi = 0;
+	trfc = 0;
+}
+
+//! Returns the weak cells of the given row.
+/*!
+  \param \e cells must have room for MAX_WEAK_CELLS cells.
+  \return The number of weak cells written to \e cells.
+*/
+uint EmulatorBackend::weakCells(uint bank, uint row, WeakCell* cells) const{
+	uint64_t x = seed ^ (((uint64_t)bank << 32) | row);
+	uint64_t h = splitmix64(x);
+
+	if((h % 1000000) >= weak_row_ratio*1000000)
+		return 0;
+
+	uint n = 1 + (h >> 32) % 2;
+	for(uint i = 0; i < n; i++){
+		uint64_t r = splitmix64(x);
+		cells[i].col = r % NUM_COLS;
+		cells[i].lane = (r >> 10) % 8;
+		cells[i].bit = (r >> 13) % 8;
+		cells[i].anti = (r >> 16) & 0x1;
+
+		double u = (double)(r >> 32)/4294967296.0;
+		cells[i].retention_ms = min_retention_ms*pow(max_retention_ms/min_retention_ms, u);
+		cells[i].vrt = ((r >> 17) & 0x3FF) < vrt_ratio*1024;
+		cells[i].hammer_acts = 0;
+	}
+
+	return n;
+}
+
+//! Returns the cells of the given row that flip when the neighbouring rows
+//are hammered.
+/*!
+  \param \e cells must have room for MAX_WEAK_CELLS cells.
+  \return The number of cells written to \e cells.
+*/
+uint EmulatorBackend::hammerCells(uint bank, uint row, WeakCell* cells) const{
+	uint64_t x = ~seed ^ (((uint64_t)bank << 32) | row);
+	uint64_t h = splitmix64(x);
+
+	if((h % 1000000) >= hammer_row_ratio*1000000)
+		return 0;
+
+	uint n = 1 + (h >> 32) % MAX_WEAK_CELLS;
+	for(uint i = 0; i < n; i++){
+		uint64_t r = splitmix64(x);
+		cells[i].col = r % NUM_COLS;
+		cells[i].lane = (r >> 10) % 8;
+		cells[i].bit = (r >> 13) % 8;
+		cells[i].anti = (r >> 16) & 0x1;
+		cells[i].retention_ms = 0;
+		cells[i].vrt = false;
+
+		double u = (double)(r >> 32)/4294967296.0;
+		cells[i].hammer_acts = min_hammer_acts*pow((double)max_hammer_acts/min_hammer_acts, u);
+	}
+
+	return n;
+}
+
+//! Returns the cycles from ACT to RD the column needs to be read correctly.
+uint EmulatorBackend::trcdCycles(uint bank, uint row, uint col) const{
+	uint64_t x = seed ^ 0x5452434400000000ULL ^ (((uint64_t)bank << 48) | ((uint64_t)row << 16) | col/EMULATOR_TIMING_COLS);
+	return min_trcd_cycles + splitmix64(x) % (max_trcd_cycles - min_trcd_cycles + 1);
+}
+
+//! Returns the cycles from PRE to ACT the column needs to be activated
+//without corrupting it.
+uint EmulatorBackend::trpCycles(uint bank, uint row, uint col) const{
+	uint64_t x = seed ^ 0x5452500000000000ULL ^ (((uint64_t)bank << 48) | ((uint64_t)row << 16) | col/EMULATOR_TIMING_COLS);
+	return min_trp_cycles + splitmix64(x) % (max_trp_cycles - min_trp_cycles + 1);
+}
+
+//! Returns the cycles from ACT to PRE the column needs to be fully restored.
+uint EmulatorBackend::trasCycles(uint bank, uint row, uint col) const{
+	uint64_t x = seed ^ 0x5452415300000000ULL ^ (((uint64_t)bank << 48) | ((uint64_t)row << 16) | col/EMULATOR_TIMING_COLS);
+	return min_tras_cycles + splitmix64(x) % (max_tras_cycles - min_tras_cycles + 1);
+}
+
+//! Returns the cycles from WR to PRE the column needs to be written.
+uint EmulatorBackend::twrCycles(uint bank, uint row, uint col) const{
+	uint64_t x = seed ^ 0x5457520000000000ULL ^ (((uint64_t)bank << 48) | ((uint64_t)row << 16) | col/EMULATOR_TIMING_COLS);
+	return min_twr_cycles + splitmix64(x) % (max_twr_cycles - min_twr_cycles + 1);
+}
+
+//! Returns the cycles from RD to PRE the column needs to be read correctly.
+uint EmulatorBackend::trtpCycles(uint bank, uint row, uint col) const{
+	uint64_t x = seed ^ 0x5452545000000000ULL ^ (((uint64_t)bank << 48) | ((uint64_t)row << 16) | col/EMULATOR_TIMING_COLS);
+	return min_trtp_cycles + splitmix64(x) % (max_trtp_cycles - min_trtp_cycles + 1);
+}
+
+//! Closes the open row of the bank at cycle \e at, corrupting it if it was
+//not open for tRAS or its last writes and reads had no time to complete.
+void EmulatorBackend::precharge(uint bank, uint64_t at){
+	int row = open_row[bank];
+	if(row >= 0){
+		// the row has not been fully restored
+		corrupt(bank, row, at - act_cycle[bank], &EmulatorBackend::trasCycles);
+
+		// the write drivers have not overwritten the cells yet
+		auto it = rows.find(bank*NUM_ROWS + row);
+		for(const Access& w : writes[bank]){
+			if(it == rows.end() || at - w.cycle >= twrCycles(bank, row, w.col))
+				continue;
+
+			uint64_t x = seed ^ w.cycle ^ ((uint64_t)w.col << 32);
+			uint64_t r = splitmix64(x);
+			it->second.flips.push_back(Flip{(uint16_t)(w.col/8*8 + r % 8), (uint8_t)((r >> 10) % 8),
+					(uint8_t)(1 << ((r >> 13) % 8))});
+		}
+
+		// the data had not left the sense amplifiers yet
+		for(const Access& rd : reads[bank]){
+			if(at - rd.cycle >= trtpCycles(bank, row, rd.col))
+				continue;
+
+			uint64_t x = seed ^ rd.cycle ^ ((uint64_t)rd.col << 32);
+			uint64_t r = splitmix64(x);
+			((uint8_t*)held[rd.burst].data())[r % BURST_BYTES] ^= 1 << ((r >> 8) % 8);
+		}
+	}
+
+	writes[bank].clear();
+	reads[bank].clear();
+	open_row[bank] = -1;
+	pre_cycle[bank] = at;
+}
+
+//! Flips a bit in every column group of the row that needs more than \e gap
+//cycles of the given timing.
+void EmulatorBackend::corrupt(uint bank, uint row, uint gap, uint (EmulatorBackend::*timing)(uint, uint, uint) const){
+	auto it = rows.find(bank*NUM_ROWS + row);
+	if(it == rows.end()) //never written
+		return;
+
+	for(uint col = 0; col < NUM_COLS; col += EMULATOR_TIMING_COLS){
+		if(gap >= (this->*timing)(bank, row, col))
+			continue;
+
+		uint64_t x = seed ^ ((uint64_t)(bank*NUM_ROWS + row) << 16) ^ col ^ cycle;
+		uint64_t r = splitmix64(x);
+
+		// the sense amplifier latches the wrong value whatever the cell held
+		it->second.flips.push_back(Flip{(uint16_t)(col + r % EMULATOR_TIMING_COLS), (uint8_t)((r >> 10) % 8),
+				(uint8_t)(1 << ((r >> 13) % 8))});
+	}
+}
+
+//! Flips the cell if it holds charge (true cells leak towards 0, anti cells
+//towards 1).
+void EmulatorBackend::flip(Row& r, const WeakCell& c){
+	uint8_t mask = 1 << c.bit;
+	uint8_t cur = r.pattern[c.col/8];
+	for(const Flip& f : r.flips)
+		if(f.col == c.col && f.lane == c.lane)
+			cur ^= f.mask;
+
+	bool charged = c.anti ? !(cur & mask) : (cur & mask);
+	if(charged)
+		r.flips.push_back(Flip{(uint16_t)c.col, (uint8_t)c.lane, mask});
+}
+
+//! Returns whether the VRT cell is in its high retention state at time \e t.
+bool EmulatorBackend::vrtHigh(uint bank, uint row, const WeakCell& c, Clock::time_point t) const{
+	uint64_t period = chrono::duration<double, milli>(t - created).count()/vrt_period_ms;
+	uint64_t cell = (((uint64_t)(bank*NUM_ROWS + row)*NUM_COLS + c.col) << 6) | (c.lane << 3) | c.bit;
+	uint64_t x = (seed ^ 0x5652540000000000ULL ^ cell) + period*0x9E3779B97F4A7C15ULL;
+	return splitmix64(x) & 0x1;
+}
+
+//! Flips the weak cells of the row that were not restored in time and marks
+//the row as restored.
+void EmulatorBackend::restore(uint bank, uint row, Clock::time_point now){
+	auto it = rows.find(bank*NUM_ROWS + row);
+	if(it == rows.end()) //never written
+		return;
+
+	Row& r = it->second;
+	double elapsed = chrono::duration<double, milli>(now - r.restored).count();
+
+	WeakCell cells[MAX_WEAK_CELLS];
+	uint n = weakCells(bank, row, cells);
+	for(uint i = 0; i < n; i++){
+		double retention = cells[i].retention_ms;
+		if(cells[i].vrt && vrtHigh(bank, row, cells[i], now))
+			retention *= EMULATOR_VRT_FACTOR;
+
+		if(retention <= elapsed)
+			flip(r, cells[i]);
+	}
+
+	if(r.disturb){
+		n = hammerCells(bank, row, cells);
+		for(uint i = 0; i < n; i++)
+			if(cells[i].hammer_acts <= r.disturb)
+				flip(r, cells[i]);
+	}
+
+	r.restored = now;
+	r.disturb = 0;
+}
+
+//! Restores the next ROWS_PER_REF rows of every bank, like a REF command.
+void EmulatorBackend::refresh(Clock::time_point now){
+	for(uint b = 0; b < NUM_BANKS; b++)
+		for(uint i = 0; i < ROWS_PER_REF; i++)
+			restore(b, ref_ptr*ROWS_PER_REF + i, now);
+	ref_ptr = (ref_ptr + 1) % (NUM_ROWS/ROWS_PER_REF);
+}
+
+void EmulatorBackend::issue(uint32_t instr){
+	uint64_t at = cycle;
+	cycle += (instr >> 28) == (uint)INSTR_TYPE::WAIT ? (instr & 0x3FF) : 1;
+
+	if(!(instr & 0x80000000)){
+		switch(instr >> 28){
+			case (uint)REGISTER::TREFI:
+				trefi = instr & 0x0FFFFFFF;
+				next_ref = Clock::now() + chrono::nanoseconds((uint64_t)trefi*REF_TICK_NS);
+				break;
+			case (uint)REGISTER::TRFC:
+				trfc = instr & 0x0FFFFFFF;
+				break;
+			default: //END, SET_BUS_DIR and WAIT do not change the DIMM state
+				break;
+		}
+		return;
+	}
+
+	uint bank = (instr >> 16) & 0x7;
+	uint addr = instr & 0xFFFF;
+	Clock::time_point now = Clock::now();
+
+	// the refreshes the engine would have issued since the last command
+	while(trefi && next_ref <= now){
+		refresh(next_ref);
+		next_ref += chrono::nanoseconds((uint64_t)trefi*REF_TICK_NS);
+	}
+
+	switch((instr >> 19) & 0x7){ //RAS, CAS, WE
+		case 0x3:{ //ACT
+			restore(bank, addr, now);
+			open_row[bank] = addr;
+			act_cycle[bank] = at;
+
+			// the bitlines have not been fully precharged (or an
+			//auto-precharge has not even started)
+			corrupt(bank, addr, at > pre_cycle[bank] ? at - pre_cycle[bank] : 0, &EmulatorBackend::trpCycles);
+
+			// disturb the neighbours that hold data
+			for(int n = (int)addr - 1; n <= (int)addr + 1; n += 2){
+				if(n < 0 || n >= NUM_ROWS)
+					continue;
+
+				auto it = rows.find(bank*NUM_ROWS + n);
+				if(it != rows.end())
+					it->second.disturb++;
+			}
+			break;
+		}
+
+		case 0x2: //PRE
+			for(int i = 0; i < NUM_BANKS; i++)
+				if(i == (int)bank || (addr & (1 << 10)))
+					precharge(i, at);
+			break;
+
+		case 0x4:{ //WR
+			if(open_row[bank] < 0)
+				break;
+
+			uint col = addr & 0x3FF;
+			uint8_t pattern = (((instr >> 25) & 0x3F) << 2) | ((instr >> 14) & 0x3);
+			uint key = bank*NUM_ROWS + open_row[bank];
+
+			auto it = rows.find(key);
+			if(it == rows.end()){
+				it = rows.emplace(key, Row()).first;
+				memset(it->second.pattern, 0, BURSTS_PER_ROW);
+				it->second.restored = now;
+				it->second.disturb = 0;
+			}
+
+			Row& r = it->second;
+			r.pattern[col/8] = pattern;
+			for(size_t i = 0; i < r.flips.size();){
+				if(r.flips[i].col/8 == col/8){
+					r.flips[i] = r.flips.back();
+					r.flips.pop_back();
+				}
+				else
+					i++;
+			}
+
+			writes[bank].push_back(Access{(uint16_t)col, at, 0});
+			if(addr & (1 << 10)) //auto-precharge
+				precharge(bank, max(at + AP_WR_CYCLES, act_cycle[bank] + AP_TRAS_CYCLES));
+			break;
+		}
+
+		case 0x5:{ //RD
+			if(open_row[bank] < 0)
+				break;
+
+			uint col = addr & 0x3FF;
+			std::array<uint, BURST_WORDS> burst;
+			uint8_t* burst8 = (uint8_t*)burst.data();
+
+			auto it = rows.find(bank*NUM_ROWS + open_row[bank]);
+			if(it == rows.end())
+				memset(burst8, 0, BURST_BYTES);
+			else{
+				memset(burst8, it->second.pattern[col/8], BURST_BYTES);
+				for(const Flip& f : it->second.flips)
+					if(f.col/8 == col/8)
+						burst8[(f.col%8)*8 + f.lane] ^= f.mask;
+
+				// the sense amplifiers have not settled yet
+				if(at - act_cycle[bank] < trcdCycles(bank, open_row[bank], col)){
+					uint64_t x = at;
+					uint64_t r = splitmix64(x);
+					burst8[r % BURST_BYTES] ^= 1 << ((r >> 8) % 8);
+				}
+			}
+
+			held.push_back(burst);
+			reads[bank].push_back(Access{(uint16_t)col, at, held.size() - 1});
+			if(addr & (1 << 10)) //auto-precharge
+				precharge(bank, max(at + AP_RD_CYCLES, act_cycle[bank] + AP_TRAS_CYCLES));
+			break;
+		}
+
+		case 0x1: //REF
+			refresh(now);
+			break;
+
+		default: //ZQ
+			break;
+	}
+}
+
+int EmulatorBackend::send(int chnl, void* data, int len){
+	if(chnl != chnls.instr)
+		return 0;
+
+	Instruction* instrs = (Instruction*)data;
+	for(int i = 0; i < len/INSTR_SIZE; i++)
+		issue((uint32_t)instrs[i]);
+
+	if(!held.empty()){
+		lock_guard<mutex> lock(rdback_lock);
+		rdback.insert(rdback.end(), held.begin(), held.end());
+		rdback_cv.notify_all();
+	}
+
+	// later PREs can no longer change the bursts
+	held.clear();
+	for(int i = 0; i < NUM_BANKS; i++)
+		reads[i].clear();
+
+	return len;
+}
+
+int EmulatorBackend::recv(int chnl, void* data, int len, long long timeout){
+	if(chnl != chnls.rdback)
+		return 0;
+
+	unique_lock<mutex> lock(rdback_lock);
+	if(timeout == 0)
+		rdback_cv.wait(lock, [this]{ return !rdback.empty(); });
+	else if(!rdback_cv.wait_for(lock, chrono::milliseconds(timeout), [this]{ return !rdback.empty(); }))
+		return 0;
+
+	int n = len < BURST_WORDS ? len : BURST_WORDS;
+	memcpy(data, rdback.front().data(), n*sizeof(uint));
+	rdback.pop_front();
+
+	return n;
+}
+
+//! Drops pending read back data, like fpga_reset. The DIMM contents are kept.
+void EmulatorBackend::reset(){
+	lock_guard<mutex> lock(rdback_lock);
+	rdback.clear();
+
+	for(int i = 0; i < NUM_BANKS; i++){
+		open_row[i] = -1;
+		writes[i].clear();
+	}
+}
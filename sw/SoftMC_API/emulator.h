@@ -0,0 +1,143 @@
+#ifndef EMULATOR_H
+#define EMULATOR_H
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "rowops.h"
+
+#define MAX_WEAK_CELLS 4
+
+// columns that share the tRCD, tRP and tRAS of the emulated DIMM
+#define EMULATOR_TIMING_COLS 128
+
+// retention time of a VRT cell in its high state, in multiples of its low one
+#define EMULATOR_VRT_FACTOR 4
+
+//! A cell that loses its charge faster than the rest of the DIMM.
+class WeakCell{
+
+	public:
+		uint col;
+		uint lane;
+		uint bit;
+		bool anti; //anti-cells lose a 0 and read back 1
+		double retention_ms;
+		bool vrt; //switches between retention_ms and EMULATOR_VRT_FACTOR times it
+		uint hammer_acts; //ACTs to the neighbour rows that flip the cell, 0 if not vulnerable
+};
+
+//! Software model of a SoftMC board and its DIMM.
+/*!
+  Interprets the instruction stream the way the hardware does and keeps the
+  contents of the DIMM in host memory. A seeded, reproducible fraction of
+  the rows have weak cells that flip if the row is not restored (written,
+  activated or refreshed) within the retention time of the cell; some of
+  them (VRT cells) switch between a low and a high retention time at random
+  every vrt_period_ms. Another fraction has cells that flip once the
+  neighbouring rows (row - 1 and row + 1, i.e. logical rows are physically
+  adjacent) have been activated hammer_acts times since the row was last
+  restored. Commands are timed in cycles (one per instruction plus the WAIT
+  cycles). A read issued less than the tRCD of its column group after the
+  ACT returns a flipped bit. An ACT less than tRP after the PRE of the bank,
+  or a PRE less than tRAS after the ACT, flips a bit of the row in every
+  column group with a longer tRP or tRAS. A PRE less than tWR after a WR or
+  tRTP after a RD of the row flips a bit of the written or read burst, so
+  read bursts are only sent back at the end of the send() that read them. WR
+  and RD with auto-precharge precharge the bank at the earliest cycle the
+  DDR3 timings allow. Once tREFI is set, the refresh engine of the board
+  refreshes the rows in turn, catching up on the REFs that were due at every
+  command. Use it in place of a board to develop and test host code.
+*/
+class EmulatorBackend : public Backend{
+
+	public:
+		EmulatorBackend(uint64_t seed = 1);
+
+		int send(int chnl, void* data, int len);
+		int recv(int chnl, void* data, int len, long long timeout = 0);
+		void reset();
+
+		uint weakCells(uint bank, uint row, WeakCell* cells) const;
+		uint hammerCells(uint bank, uint row, WeakCell* cells) const;
+		uint trcdCycles(uint bank, uint row, uint col) const;
+		uint trpCycles(uint bank, uint row, uint col) const;
+		uint trasCycles(uint bank, uint row, uint col) const;
+		uint twrCycles(uint bank, uint row, uint col) const;
+		uint trtpCycles(uint bank, uint row, uint col) const;
+
+		uint64_t seed;
+		double weak_row_ratio; //fraction of the rows that have weak cells
+		double min_retention_ms;
+		double max_retention_ms;
+		double vrt_ratio; //fraction of the weak cells that have variable retention times
+		double vrt_period_ms;
+		double hammer_row_ratio; //fraction of the rows that have cells vulnerable to hammering
+		uint min_hammer_acts;
+		uint max_hammer_acts;
+		uint min_trcd_cycles; //ACT to RD cycles the column groups need
+		uint max_trcd_cycles;
+		uint min_trp_cycles; //PRE to ACT cycles the column groups need
+		uint max_trp_cycles;
+		uint min_tras_cycles; //ACT to PRE cycles the column groups need
+		uint max_tras_cycles;
+		uint min_twr_cycles; //WR to PRE cycles the column groups need to be written
+		uint max_twr_cycles;
+		uint min_trtp_cycles; //RD to PRE cycles the column groups need to be read
+		uint max_trtp_cycles;
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		struct Flip{
+			uint16_t col;
+			uint8_t lane;
+			uint8_t mask;
+		};
+
+		//! A WR or RD to the open row of a bank.
+		struct Access{
+			uint16_t col;
+			uint64_t cycle;
+			size_t burst; //of a RD, in held
+		};
+
+		struct Row{
+			uint8_t pattern[BURSTS_PER_ROW];
+			Clock::time_point restored;
+			std::vector<Flip> flips;
+			uint32_t disturb; //ACTs to the neighbour rows since the last restore
+		};
+
+		void issue(uint32_t instr);
+		void restore(uint bank, uint row, Clock::time_point now);
+		bool vrtHigh(uint bank, uint row, const WeakCell& c, Clock::time_point t) const;
+		void refresh(Clock::time_point now);
+		void flip(Row& r, const WeakCell& c);
+		void corrupt(uint bank, uint row, uint gap, uint (EmulatorBackend::*timing)(uint, uint, uint) const);
+		void precharge(uint bank, uint64_t at);
+
+		std::unordered_map<uint, Row> rows;
+		Clock::time_point created; //start of the first VRT period
+		int open_row[NUM_BANKS];
+		uint64_t cycle; //issue cycle of the next instruction
+		uint64_t act_cycle[NUM_BANKS];
+		uint64_t pre_cycle[NUM_BANKS];
+		std::vector<Access> writes[NUM_BANKS]; //since the ACT
+		std::vector<Access> reads[NUM_BANKS];
+		std::vector<std::array<uint, BURST_WORDS> > held; //read bursts of the current send
+		uint ref_ptr;
+		uint trefi;
+		uint trfc;
+		Clock::time_point next_ref; //of the refresh engine, if trefi is set
+
+		std::mutex rdback_lock;
+		std::condition_variable rdback_cv;
+		std::deque<std::array<uint, BURST_WORDS> > rdback;
+};
+
+#endif //EMULATOR_H
@@ -0,0 +1,216 @@
+#include "errlog.h"
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static uint64_t nowMicros(){
+	return chrono::duration_cast<chrono::microseconds>(
+			chrono::system_clock::now().time_since_epoch()).count();
+}
+
+ErrorLogWriter::ErrorLogWriter(const char* path, uint32_t run_id, uint32_t retention_ms, uint8_t dimm){
+	this->run_id = run_id;
+	this->retention_ms = retention_ms;
+	this->dimm = dimm;
+	map = nullptr;
+
+	file = fopen(path, "ab");
+	if(!file)
+		return;
+
+	// a new log starts with a header, existing ones are appended to
+	if(ftell(file) == 0){
+		ErrorFileHeader hdr;
+		memset(&hdr, 0, sizeof(hdr));
+		hdr.magic = ERRLOG_MAGIC;
+		hdr.record_size = sizeof(ErrorRecord);
+		fwrite(&hdr, sizeof(hdr), 1, file);
+	}
+
+	buf.reserve(buf_cap);
+}
+
+ErrorLogWriter::~ErrorLogWriter(){
+	if(file){
+		flush();
+		fclose(file);
+	}
+}
+
+void ErrorLogWriter::add(const ReadError& err){
+	add(err, dimm);
+}
+
+void ErrorLogWriter::add(const ReadError& err, uint8_t dimm){
+	add(err, dimm, retention_ms);
+}
+
+void ErrorLogWriter::add(const ReadError& err, uint8_t dimm, uint32_t retention_ms, uint8_t pattern){
+	if(!file)
+		return;
+
+	ErrorRecord r;
+	memset(&r, 0, sizeof(r));
+	r.timestamp_us = nowMicros();
+	r.run_id = run_id;
+	r.row = err.row;
+	r.retention_ms = retention_ms;
+	r.col = err.col;
+	r.bank = err.bank;
+	r.lane = err.lane;
+	r.mask = err.data ^ err.expected;
+	r.dimm = dimm;
+	r.phys_row = map ? map->toPhysical(err.row) : err.row;
+	r.pattern = pattern;
+
+	buf.push_back(r);
+	if(buf.size() == buf_cap)
+		flush();
+}
+
+void ErrorLogWriter::flush(){
+	if(!file)
+		return;
+
+	if(!buf.empty())
+		fwrite(buf.data(), sizeof(ErrorRecord), buf.size(), file);
+	buf.clear();
+	fflush(file);
+}
+
+ErrorLogReader::ErrorLogReader(){
+	log_map = index_map = nullptr;
+	log_len = index_len = 0;
+	records = nullptr;
+	entries = nullptr;
+	num_records = num_entries = 0;
+}
+
+ErrorLogReader::~ErrorLogReader(){
+	close();
+}
+
+//! Maps the whole file read-only. Returns nullptr for missing or empty files.
+static void* mapFile(const char* path, size_t& len){
+	int fd = ::open(path, O_RDONLY);
+	if(fd < 0)
+		return nullptr;
+
+	struct stat st;
+	void* p = nullptr;
+	if(fstat(fd, &st) == 0 && st.st_size > 0){
+		len = st.st_size;
+		p = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+		if(p == MAP_FAILED)
+			p = nullptr;
+	}
+
+	::close(fd);
+	return p;
+}
+
+static bool validHeader(const void* p, size_t len, uint64_t magic, uint32_t record_size){
+	const ErrorFileHeader* hdr = (const ErrorFileHeader*)p;
+	return len >= sizeof(ErrorFileHeader) && hdr->magic == magic && hdr->record_size == record_size;
+}
+
+//! Sorts the records of the log by (bank, row) into an index file.
+/*!
+  Records of the same row keep their order in the log.
+  \return false if the log cannot be read or the index cannot be written.
+*/
+bool ErrorLogReader::buildIndex(const char* log_path, const char* index_path){
+	size_t len = 0;
+	void* p = mapFile(log_path, len);
+	if(!p)
+		return false;
+
+	if(!validHeader(p, len, ERRLOG_MAGIC, sizeof(ErrorRecord))){
+		munmap(p, len);
+		return false;
+	}
+
+	uint64_t n = (len - sizeof(ErrorFileHeader))/sizeof(ErrorRecord);
+	const ErrorRecord* recs = (const ErrorRecord*)((const char*)p + sizeof(ErrorFileHeader));
+
+	vector<ErrorIndexEntry> idx(n);
+	for(uint64_t i = 0; i < n; i++){
+		idx[i].key = ((uint64_t)recs[i].bank << 32) | recs[i].row;
+		idx[i].record = i;
+	}
+	munmap(p, len);
+
+	stable_sort(idx.begin(), idx.end(),
+			[](const ErrorIndexEntry& a, const ErrorIndexEntry& b){ return a.key < b.key; });
+
+	FILE* f = fopen(index_path, "wb");
+	if(!f)
+		return false;
+
+	ErrorFileHeader hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = ERRIDX_MAGIC;
+	hdr.record_size = sizeof(ErrorIndexEntry);
+	hdr.count = n;
+
+	bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+		fwrite(idx.data(), sizeof(ErrorIndexEntry), n, f) == n;
+
+	return (fclose(f) == 0) && ok;
+}
+
+//! Maps the log and its index built with buildIndex.
+/*!
+  Records appended to the log after the index was built are not queried,
+ entries that point past the end of a truncated log are skipped.
+  \return false if either file is missing or malformed.
+*/
+bool ErrorLogReader::open(const char* log_path, const char* index_path){
+	close();
+
+	log_map = mapFile(log_path, log_len);
+	index_map = mapFile(index_path, index_len);
+
+	if(!log_map || !index_map ||
+			!validHeader(log_map, log_len, ERRLOG_MAGIC, sizeof(ErrorRecord)) ||
+			!validHeader(index_map, index_len, ERRIDX_MAGIC, sizeof(ErrorIndexEntry))){
+		close();
+		return false;
+	}
+
+	records = (const ErrorRecord*)((const char*)log_map + sizeof(ErrorFileHeader));
+	num_records = (log_len - sizeof(ErrorFileHeader))/sizeof(ErrorRecord);
+	entries = (const ErrorIndexEntry*)((const char*)index_map + sizeof(ErrorFileHeader));
+	num_entries = ((const ErrorFileHeader*)index_map)->count;
+
+	if(sizeof(ErrorFileHeader) + num_entries*sizeof(ErrorIndexEntry) > index_len){
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void ErrorLogReader::close(){
+	if(log_map)
+		munmap(log_map, log_len);
+	if(index_map)
+		munmap(index_map, index_len);
+
+	log_map = index_map = nullptr;
+	log_len = index_len = 0;
+	records = nullptr;
+	entries = nullptr;
+	num_records = num_entries = 0;
+}
+
+const ErrorIndexEntry* ErrorLogReader::lowerBound(uint64_t key) const{
+	return lower_bound(entries, entries + num_entries, key,
+			[](const ErrorIndexEntry& e, uint64_t k){ return e.key < k; });
+}
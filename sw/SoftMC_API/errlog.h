@@ -0,0 +1,133 @@
+#ifndef ERRLOG_H
+#define ERRLOG_H
+
+#include <stdio.h>
+#include <vector>
+#include "rowops.h"
+#include "rowmap.h"
+
+#define ERRLOG_MAGIC 0x31474F4C52454D53ULL //"SMERLOG1"
+#define ERRIDX_MAGIC 0x3158444952454D53ULL //"SMERIDX1"
+
+//! Fixed-width binary record of a single failing byte.
+class ErrorRecord{
+
+	public:
+		uint64_t timestamp_us; //wall clock time of the read back
+		uint32_t run_id;
+		uint32_t row;
+		uint32_t retention_ms;
+		uint16_t col;
+		uint8_t bank;
+		uint8_t lane;
+		uint8_t mask; //bits that differ from the written pattern
+		uint8_t dimm;
+		uint16_t phys_row; //physical row, see ErrorLogWriter::map
+		uint8_t pattern; //DATA_PATTERN + 1 of a data pattern test, 0 for the 0xff pattern of the other tests
+		uint8_t reserved[3];
+};
+
+static_assert(sizeof(ErrorRecord) == 32, "ErrorRecord must stay 32 bytes wide");
+
+//! Header of error log and index files.
+class ErrorFileHeader{
+
+	public:
+		uint64_t magic;
+		uint32_t record_size;
+		uint32_t reserved;
+		uint64_t count; //number of entries in an index, unused in logs
+};
+
+//! Buffered writer of ErrorRecords.
+/*!
+  Appends to the log if it already exists. Not thread-safe; use one writer
+  per thread or merge the errors first.
+*/
+class ErrorLogWriter{
+
+	public:
+		ErrorLogWriter(const char* path, uint32_t run_id, uint32_t retention_ms, uint8_t dimm = 0);
+		virtual ~ErrorLogWriter();
+
+		bool good() const { return file != nullptr; }
+
+		void add(const ReadError& err);
+		void add(const ReadError& err, uint8_t dimm);
+		void add(const ReadError& err, uint8_t dimm, uint32_t retention_ms, uint8_t pattern = 0);
+		void flush();
+
+		uint32_t run_id;
+		uint32_t retention_ms;
+		uint8_t dimm;
+		const RowMap* map; //translates the rows to physical rows if set
+
+	private:
+		const static uint buf_cap = 32768; //records (1 MiB)
+
+		FILE* file;
+		std::vector<ErrorRecord> buf;
+};
+
+//! Index entry, sorted by key = (bank << 32) | row.
+class ErrorIndexEntry{
+
+	public:
+		uint64_t key;
+		uint64_t record;
+};
+
+//! Read-only, memory-mapped view of an error log and its index.
+class ErrorLogReader{
+
+	public:
+		ErrorLogReader();
+		virtual ~ErrorLogReader();
+
+		bool open(const char* log_path, const char* index_path);
+		void close();
+
+		static bool buildIndex(const char* log_path, const char* index_path);
+
+		uint64_t size() const { return num_records; }
+		const ErrorRecord& record(uint64_t i) const { return records[i]; }
+
+		template<typename F>
+		uint64_t query(uint bank, uint row_begin, uint row_end, F f) const;
+
+	private:
+		const ErrorIndexEntry* lowerBound(uint64_t key) const;
+
+		void* log_map;
+		size_t log_len;
+		void* index_map;
+		size_t index_len;
+
+		const ErrorRecord* records;
+		uint64_t num_records;
+		const ErrorIndexEntry* entries;
+		uint64_t num_entries;
+};
+
+//! Calls f for every record of the given bank with a row in [row_begin, row_end].
+/*!
+  \return The number of matching records.
+*/
+template<typename F>
+uint64_t ErrorLogReader::query(uint bank, uint row_begin, uint row_end, F f) const{
+	uint64_t end_key = ((uint64_t)bank << 32) | row_end;
+	uint64_t n = 0;
+
+	for(const ErrorIndexEntry* e = lowerBound(((uint64_t)bank << 32) | row_begin);
+			e < entries + num_entries && e->key <= end_key; e++){
+		if(e->record >= num_records)
+			continue;
+
+		f(records[e->record]);
+		n++;
+	}
+
+	return n;
+}
+
+#endif //ERRLOG_H
@@ -0,0 +1,33 @@
+#include "fill.h"
+#include "scheduler.h"
+
+//! Writes the pattern to every row of the order at the peak write bandwidth
+//of the DRAM bus.
+/*!
+  One row of every bank is written per group (see StreamPlan), with back to
+ back bursts.
+  \return The rows written, the host time and the fraction of the issued
+ cycles the data bus is busy.
+*/
+FillStats fill(Backend* be, const RowOrder& order, const uint8_t pattern){
+	StreamPlan plan(order);
+	InstructionSequence* iseq = nullptr;
+	FillStats st;
+
+	uint64_t start = DeadlineScheduler::now();
+	turnBus(be, BUSDIR::WRITE, iseq);
+
+	StreamStats ss = streamRows(be, plan, true, pattern);
+
+	st.ms = (DeadlineScheduler::now() - start)/1e6;
+	st.rows = plan.rows.size();
+	st.bus_efficiency = ss.busEfficiency();
+
+	delete iseq;
+	return st;
+}
+
+//! Writes the pattern to the entire DIMM, e.g. to scrub it after a test.
+FillStats fillDimm(Backend* be, const uint8_t pattern){
+	return fill(be, BankMajorOrder(), pattern);
+}
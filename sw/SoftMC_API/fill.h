@@ -0,0 +1,28 @@
+#ifndef FILL_H
+#define FILL_H
+
+#include "stream.h"
+
+//! Outcome of a fill.
+class FillStats{
+
+	public:
+		uint64_t rows;
+		double ms; //host time to send the sequences
+		double bus_efficiency; //fraction of the issued cycles the data bus is busy
+
+		FillStats(){ rows = 0; ms = 0; bus_efficiency = 0; }
+
+		uint64_t bytes() const { return rows*NUM_COLS*8; }
+
+		//! Achieved bandwidth, limited by whichever of the host and the DRAM is slower.
+		double gbps() const { return ms > 0 ? bytes()/ms/1e6 : 0; }
+
+		//! Bandwidth the issued sequences reach on the DRAM bus.
+		double busGbps() const { return DDR3_PEAK_GBPS*bus_efficiency; }
+};
+
+FillStats fill(Backend* be, const RowOrder& order, const uint8_t pattern);
+FillStats fillDimm(Backend* be, const uint8_t pattern);
+
+#endif //FILL_H
@@ -0,0 +1,187 @@
+#include "hammer.h"
+#include "scheduler.h"
+
+//! Translates physical rows to logical ones, dropping those off the bank.
+static void addRows(std::vector<uint>& out, const std::vector<int>& phys, const RowMap* map){
+	for(int r : phys){
+		if(r < 0 || r >= NUM_ROWS)
+			continue;
+		out.push_back(map ? map->toLogical(r) : r);
+	}
+}
+
+//! Hammers a single row; its two physical neighbours are the victims.
+/*!
+  The rows are given as physical rows if \e map is set, otherwise logical
+ rows are assumed to be physically adjacent.
+*/
+HammerPattern HammerPattern::singleSided(uint bank, uint aggressor, const RowMap* map){
+	HammerPattern p(bank);
+	int a = map ? map->toPhysical(aggressor) : aggressor;
+
+	p.aggressors.push_back(aggressor);
+	addRows(p.victims, {a - 1, a + 1}, map);
+
+	return p;
+}
+
+//! Hammers both physical neighbours of the victim.
+HammerPattern HammerPattern::doubleSided(uint bank, uint victim, const RowMap* map){
+	HammerPattern p(bank);
+	int v = map ? map->toPhysical(victim) : victim;
+
+	addRows(p.aggressors, {v - 1, v + 1}, map);
+	p.victims.push_back(victim);
+
+	return p;
+}
+
+//! Hammers \e num_aggressors rows spaced two rows apart, starting right
+//before the first victim; the rows in between (and next to the last
+//aggressor) are the victims.
+HammerPattern HammerPattern::manySided(uint bank, uint first_victim, uint num_aggressors, const RowMap* map){
+	HammerPattern p(bank);
+	int v = map ? map->toPhysical(first_victim) : first_victim;
+
+	std::vector<int> aggr, vict;
+	for(uint i = 0; i < num_aggressors; i++){
+		aggr.push_back(v - 1 + 2*i);
+		if(i + 1 < num_aggressors)
+			vict.push_back(v + 2*i);
+	}
+
+	addRows(p.aggressors, aggr, map);
+	addRows(p.victims, vict, map);
+
+	return p;
+}
+
+//! Returns how many rounds (one ACT to every aggressor) fit in a sequence.
+uint hammerRounds(const HammerPattern& p){
+	return hammerRounds(std::vector<HammerPattern>(1, p));
+}
+
+//! Returns how many rounds of hammering the patterns together fit in a
+//sequence.
+uint hammerRounds(const std::vector<HammerPattern>& ps){
+	if(ps.empty() || ps.front().aggressors.empty())
+		return 0;
+
+	//an ACT and a WAIT per pattern followed by PRE and WAIT for every
+	//aggressor, one slot is left for END
+	return (MAX_INSTRS - 1)/(ps.front().aggressors.size()*(2*ps.size() + 2));
+}
+
+//! Appends \e rounds rounds of hammering and an END to the sequence.
+void genHammer(const HammerPattern& p, uint rounds, InstructionSequence* iseq){
+	genHammer(std::vector<HammerPattern>(1, p), rounds, iseq);
+}
+
+//! Appends \e rounds rounds of hammering the patterns together and an END
+//to the sequence.
+/*!
+  The patterns must be in different banks and have the same number of
+ aggressors. The i-th aggressors of all patterns are activated back to back
+ and precharged together, so hammering N banks takes little longer than
+ hammering one.
+*/
+void genHammer(const std::vector<HammerPattern>& ps, uint rounds, InstructionSequence* iseq){
+	uint n = ps.empty() ? 0 : ps.front().aggressors.size();
+
+	for(uint i = 0; i < rounds; i++){
+		for(uint a = 0; a < n; a++){
+			for(uint k = 0; k < ps.size(); k++){
+				iseq->insert(genACT(ps[k].bank, ps[k].aggressors[a]));
+
+				//Wait for tRRD, or tRAS after the last ACT
+				iseq->insert(genWAIT(k + 1 < ps.size() ? HAMMER_TRRD_WAIT : HAMMER_TRAS_WAIT));
+			}
+
+			if(ps.size() == 1)
+				iseq->insert(genPRE(ps.front().bank, PRE_TYPE::SINGLE));
+			else
+				iseq->insert(genPRE(0, PRE_TYPE::ALL));
+
+			//Wait for tRP
+			iseq->insert(genWAIT(HAMMER_TRP_WAIT));
+		}
+	}
+
+	//START Transaction
+	iseq->insert(genEND());
+}
+
+//! Activates every aggressor \e hammers times, as fast as tRAS and tRP allow.
+/*!
+  The hardware has no loops, so a full instruction buffer of hammer rounds is
+ generated once and sent as many times as needed, followed by a shorter
+ sequence for the remaining rounds.
+  \param \e iseq is reused to avoid a dynamic allocation on each call.
+  \return The number of ACT commands issued.
+*/
+uint64_t hammer(Backend* be, const HammerPattern& p, uint hammers, InstructionSequence*& iseq){
+	return hammer(be, std::vector<HammerPattern>(1, p), hammers, iseq);
+}
+
+//! Hammers the patterns together, see genHammer for the requirements.
+uint64_t hammer(Backend* be, const std::vector<HammerPattern>& ps, uint hammers, InstructionSequence*& iseq){
+	uint per_seq = hammerRounds(ps);
+	if(per_seq == 0 || hammers == 0)
+		return 0;
+
+	if(iseq == nullptr)
+		iseq = new InstructionSequence(MAX_INSTRS);
+
+	if(hammers >= per_seq){
+		iseq->size = 0;
+		genHammer(ps, per_seq, iseq);
+
+		for(uint i = 0; i < hammers/per_seq; i++)
+			iseq->execute(be);
+	}
+
+	if(hammers%per_seq){
+		iseq->size = 0;
+		genHammer(ps, hammers%per_seq, iseq);
+		iseq->execute(be);
+	}
+
+	return (uint64_t)hammers*ps.front().aggressors.size()*ps.size();
+}
+
+//! Initializes the rows, hammers the aggressors and checks the victims.
+/*!
+  \param \e victim_pattern is written to the victims and expected back.
+  \param \e aggressor_pattern is written to the aggressors.
+  \param \e sink receives every mismatching byte of the victims.
+*/
+HammerResult testHammer(Backend* be, const HammerPattern& p, uint hammers,
+		uint8_t victim_pattern, uint8_t aggressor_pattern, const ErrorSink& sink){
+
+	InstructionSequence* iseq = nullptr;
+	HammerResult res;
+
+	turnBus(be, BUSDIR::WRITE, iseq);
+	for(uint v : p.victims)
+		writeRow(be, v, p.bank, victim_pattern, iseq);
+	for(uint a : p.aggressors)
+		writeRow(be, a, p.bank, aggressor_pattern, iseq);
+
+	uint64_t start = DeadlineScheduler::now();
+	res.acts = hammer(be, p, hammers, iseq);
+
+	// the read back below waits for the hammering to finish
+	turnBus(be, BUSDIR::READ, iseq);
+	for(uint v : p.victims){
+		readAndCompareRow(be, v, p.bank, victim_pattern, iseq, [&](const ReadError& e){
+			res.errors++;
+			sink(e);
+		});
+
+		if(v == p.victims.front())
+			res.hammer_ms = (DeadlineScheduler::now() - start)/1e6;
+	}
+
+	delete iseq;
+	return res;
+}
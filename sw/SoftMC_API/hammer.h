@@ -0,0 +1,52 @@
+#ifndef HAMMER_H
+#define HAMMER_H
+
+#include <vector>
+#include "rowops.h"
+#include "rowmap.h"
+
+// WAIT cycles after ACT (tRAS = 35 ns) and PRE (tRP = 15 ns), one cycle
+//has already passed when the WAIT is issued
+#define HAMMER_TRAS_WAIT 13
+#define HAMMER_TRP_WAIT 5
+// WAIT cycles between ACTs to different banks (10 ns, covers tRRD and tFAW/4)
+#define HAMMER_TRRD_WAIT 3
+
+//! Aggressor and victim rows of a bank for a disturbance test.
+class HammerPattern{
+
+	public:
+		uint bank;
+		std::vector<uint> aggressors; //activated round-robin, a row may repeat
+		std::vector<uint> victims; //checked after hammering
+
+		HammerPattern() : HammerPattern(0){}
+		HammerPattern(uint bank){ this->bank = bank; }
+
+		static HammerPattern singleSided(uint bank, uint aggressor, const RowMap* map = nullptr);
+		static HammerPattern doubleSided(uint bank, uint victim, const RowMap* map = nullptr);
+		static HammerPattern manySided(uint bank, uint first_victim, uint num_aggressors, const RowMap* map = nullptr);
+};
+
+//! Outcome of a hammer run.
+class HammerResult{
+
+	public:
+		uint64_t acts; //ACT commands issued
+		double hammer_ms; //until the first victim was read back
+		uint errors; //mismatching bytes in the victims
+
+		HammerResult(){ acts = 0; hammer_ms = 0; errors = 0; }
+};
+
+uint hammerRounds(const HammerPattern& p);
+uint hammerRounds(const std::vector<HammerPattern>& ps);
+void genHammer(const HammerPattern& p, uint rounds, InstructionSequence* iseq);
+void genHammer(const std::vector<HammerPattern>& ps, uint rounds, InstructionSequence* iseq);
+uint64_t hammer(Backend* be, const HammerPattern& p, uint hammers, InstructionSequence*& iseq);
+uint64_t hammer(Backend* be, const std::vector<HammerPattern>& ps, uint hammers, InstructionSequence*& iseq);
+
+HammerResult testHammer(Backend* be, const HammerPattern& p, uint hammers,
+		uint8_t victim_pattern, uint8_t aggressor_pattern, const ErrorSink& sink);
+
+#endif //HAMMER_H
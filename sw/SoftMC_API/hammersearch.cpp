@@ -0,0 +1,224 @@
+#include "hammersearch.h"
+#include "retention.h"
+#include <stdio.h>
+#include <algorithm>
+
+using namespace std;
+
+//! Returns the aggressors (0 is the lowest row) in the order they are
+//activated during a round.
+vector<uint> HammerCandidate::sequence() const{
+	vector<uint> idx;
+	switch(order){
+		case HAMMER_ORDER::OUTSIDE_IN:
+			for(uint lo = 0, hi = sides; lo < hi; lo++){
+				idx.push_back(lo);
+				if(lo < --hi)
+					idx.push_back(hi);
+			}
+			break;
+
+		case HAMMER_ORDER::INTERLEAVED:
+			for(uint i = 0; i < sides; i += 2)
+				idx.push_back(i);
+			for(uint i = 1; i < sides; i += 2)
+				idx.push_back(i);
+			break;
+
+		default:
+			for(uint i = 0; i < sides; i++)
+				idx.push_back(i);
+			break;
+	}
+
+	// the outermost aggressors are activated again in the extra passes
+	vector<uint> seq;
+	for(uint pass = 0; pass < max(boost, 1u); pass++)
+		for(uint i : idx)
+			if(pass == 0 || i == 0 || i + 1 == sides)
+				seq.push_back(i);
+
+	return seq;
+}
+
+//! Returns the number of physical rows the candidate covers, from the
+//victim below the first aggressor to the one above the last.
+uint HammerCandidate::span() const{
+	return sides ? (sides - 1)*spacing + 3 : 0;
+}
+
+//! Places the candidate in a bank.
+/*!
+  \param \e first_row is the physical row of the lowest victim. Every row of
+ the span that is not an aggressor is a victim.
+  \param \e map translates the physical rows to logical ones, logical rows
+ are assumed to be physically adjacent if not given.
+*/
+HammerPattern HammerCandidate::place(uint bank, uint first_row, const RowMap* map) const{
+	HammerPattern p(bank);
+
+	auto logical = [map](uint r){ return map ? map->toLogical(r) : r; };
+
+	for(uint i : sequence())
+		p.aggressors.push_back(logical(first_row + 1 + i*spacing));
+
+	for(uint r = first_row; r < first_row + span() && r < NUM_ROWS; r++)
+		if(r <= first_row || (r - first_row - 1)%spacing || (r - first_row - 1)/spacing >= sides)
+			p.victims.push_back(logical(r));
+
+	return p;
+}
+
+std::string HammerCandidate::name() const{
+	const char* orders[] = {"sequential", "outside-in", "interleaved"};
+
+	char buf[96];
+	snprintf(buf, sizeof(buf), "%u-sided, spacing %u, %s, boost %u", sides, spacing,
+			orders[(int)order], boost);
+	return buf;
+}
+
+//! Returns the distinct candidates with the given numbers of aggressors and
+//spacings, in every order and with boosts up to \e max_boost.
+/*!
+  Orders and boosts that result in the same activation sequence are
+ generated once, spacing and boost do not apply to single-sided candidates.
+*/
+vector<HammerCandidate> hammerCandidates(const vector<uint>& sides, const vector<uint>& spacings,
+		const uint max_boost){
+
+	const HAMMER_ORDER orders[] = {HAMMER_ORDER::SEQUENTIAL, HAMMER_ORDER::OUTSIDE_IN,
+		HAMMER_ORDER::INTERLEAVED};
+
+	vector<HammerCandidate> res;
+	for(uint s : sides){
+		if(s == 0)
+			continue;
+
+		for(uint sp : spacings){
+			if(sp == 0 || (s == 1 && sp != spacings.front()))
+				continue;
+
+			for(uint b = 1; b <= (s == 1 ? 1 : max(max_boost, 1u)); b++){
+				size_t first = res.size();
+				for(HAMMER_ORDER o : orders){
+					HammerCandidate c(s, sp, o, b);
+					vector<uint> seq = c.sequence();
+
+					if(none_of(res.begin() + first, res.end(),
+								[&seq](const HammerCandidate& d){ return d.sequence() == seq; }))
+						res.push_back(c);
+				}
+			}
+		}
+	}
+
+	return res;
+}
+
+//! A candidate placed in a bank.
+class HammerJob{
+
+	public:
+		uint candidate; //index in the candidate list
+		HammerPattern pattern;
+
+		HammerJob(uint candidate, const HammerPattern& pattern){
+			this->candidate = candidate; this->pattern = pattern;
+		}
+};
+
+//! Hammers every candidate at every place and ranks the candidates by
+//flipped bits per ACT.
+/*!
+  Candidates with the same number of ACTs per round are hammered together,
+ up to one per bank, in a single sequence (see genHammer), and their victims
+ are read back in a single row group.
+  \param \e places are the physical rows of the lowest victim; placements
+ that do not fit in the bank are skipped.
+  \param \e hammers is the number of rounds each placement is hammered for.
+  \return The scores, best candidate first.
+*/
+vector<HammerScore> searchHammerPatterns(Backend* be, const vector<HammerCandidate>& candidates,
+		const vector<DramAddr>& places, const uint hammers, const uint8_t victim_pattern,
+		const uint8_t aggressor_pattern, const RowMap* map, const bool progress){
+
+	vector<HammerScore> scores(candidates.begin(), candidates.end());
+
+	// every batch has one job per bank at most and a single round length
+	vector<vector<HammerJob>> batches;
+	for(const DramAddr& at : places){
+		for(uint c = 0; c < candidates.size(); c++){
+			if(at.bank >= NUM_BANKS || at.row + candidates[c].span() > NUM_ROWS)
+				continue;
+
+			HammerJob job(c, candidates[c].place(at.bank, at.row, map));
+
+			auto fits = [&job](const vector<HammerJob>& b){
+				return b.front().pattern.aggressors.size() == job.pattern.aggressors.size() &&
+					none_of(b.begin(), b.end(), [&job](const HammerJob& j){ return j.pattern.bank == job.pattern.bank; });
+			};
+
+			auto it = find_if(batches.begin(), batches.end(), fits);
+			if(it == batches.end())
+				batches.push_back(vector<HammerJob>(1, job));
+			else
+				it->push_back(job);
+		}
+	}
+
+	InstructionSequence* iseq = nullptr;
+	uint done = 0;
+
+	for(const vector<HammerJob>& batch : batches){
+		vector<HammerPattern> patterns;
+		vector<uint> victims, aggressors; //linear rows
+		for(const HammerJob& j : batch){
+			patterns.push_back(j.pattern);
+			for(uint v : j.pattern.victims)
+				victims.push_back(j.pattern.bank*NUM_ROWS + v);
+			for(uint a : j.pattern.aggressors)
+				aggressors.push_back(j.pattern.bank*NUM_ROWS + a);
+		}
+
+		sort(aggressors.begin(), aggressors.end());
+		aggressors.erase(unique(aggressors.begin(), aggressors.end()), aggressors.end());
+
+		writeRowGroup(be, victims.data(), victims.size(), victim_pattern, iseq);
+		writeRowGroup(be, aggressors.data(), aggressors.size(), aggressor_pattern, iseq);
+
+		hammer(be, patterns, hammers, iseq);
+
+		uint64_t flips[NUM_BANKS] = {};
+		readRowGroup(be, victims.data(), victims.size(), victim_pattern, [&flips](const ReadError& e){
+			flips[e.bank] += __builtin_popcount(e.data ^ e.expected);
+		}, iseq);
+
+		for(const HammerJob& j : batch){
+			HammerScore& s = scores[j.candidate];
+			s.tests++;
+			s.acts += (uint64_t)hammers*j.pattern.aggressors.size();
+			s.flips += flips[j.pattern.bank];
+			if(flips[j.pattern.bank])
+				s.flipped++;
+		}
+
+		done++;
+		if(progress){
+			printf("%c[2K\r", 27);
+			printf("Completed %u of %zu batches", done, batches.size());
+			fflush(stdout);
+		}
+	}
+
+	if(progress)
+		printf("\n");
+
+	delete iseq;
+
+	stable_sort(scores.begin(), scores.end(), [](const HammerScore& a, const HammerScore& b){
+		return a.rate() > b.rate();
+	});
+
+	return scores;
+}
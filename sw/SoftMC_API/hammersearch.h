@@ -0,0 +1,58 @@
+#ifndef HAMMERSEARCH_H
+#define HAMMERSEARCH_H
+
+#include <string>
+#include <vector>
+#include "hammer.h"
+
+enum class HAMMER_ORDER {
+	SEQUENTIAL = 0, //lowest to highest row
+	OUTSIDE_IN = 1, //first, last, second, second to last, ...
+	INTERLEAVED = 2 //even aggressors, then odd ones
+};
+
+//! An aggressor pattern to evaluate, independent of where it is placed.
+class HammerCandidate{
+
+	public:
+		uint sides; //number of distinct aggressor rows
+		uint spacing; //physical rows from one aggressor to the next
+		HAMMER_ORDER order; //activation order of the aggressors in a round
+		uint boost; //ACTs per round to the two outermost aggressors, the others get one
+
+		HammerCandidate() : HammerCandidate(2, 2, HAMMER_ORDER::SEQUENTIAL, 1){}
+		HammerCandidate(uint sides, uint spacing, HAMMER_ORDER order, uint boost){
+			this->sides = sides; this->spacing = spacing; this->order = order; this->boost = boost;
+		}
+
+		std::vector<uint> sequence() const;
+		uint span() const;
+		HammerPattern place(uint bank, uint first_row, const RowMap* map = nullptr) const;
+		std::string name() const;
+};
+
+//! How many bits a candidate flipped with how many ACTs.
+class HammerScore{
+
+	public:
+		HammerCandidate candidate;
+		uint tests; //placements hammered
+		uint flipped; //placements with at least one flipped bit
+		uint64_t acts;
+		uint64_t flips; //flipped bits in the victims
+
+		HammerScore() : HammerScore(HammerCandidate()){}
+		HammerScore(const HammerCandidate& c){ candidate = c; tests = 0; flipped = 0; acts = 0; flips = 0; }
+
+		//! Flipped bits per million ACTs.
+		double rate() const { return acts ? flips*1e6/acts : 0; }
+};
+
+std::vector<HammerCandidate> hammerCandidates(const std::vector<uint>& sides,
+		const std::vector<uint>& spacings, const uint max_boost);
+
+std::vector<HammerScore> searchHammerPatterns(Backend* be, const std::vector<HammerCandidate>& candidates,
+		const std::vector<DramAddr>& places, const uint hammers, const uint8_t victim_pattern,
+		const uint8_t aggressor_pattern, const RowMap* map = nullptr, const bool progress = false);
+
+#endif //HAMMERSEARCH_H
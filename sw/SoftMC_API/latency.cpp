@@ -0,0 +1,681 @@
+#include "latency.h"
+#include "retention.h"
+#include <stdio.h>
+#include <algorithm>
+#include <array>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+// rows read by a single sequence, every burst needs up to 6 instructions
+#define TRCD_BATCH_ROWS ((MAX_INSTRS - 1)/(6*BURSTS_PER_ROW))
+
+// rows measured per sequence by the tRP and tRAS harnesses
+#define GAP_BATCH_ROWS 64
+
+#define NO_ROW 0xFFFFFFFF
+
+//! Reads every burst of TRCD_BATCH_ROWS rows, each burst right after its own
+//ACT with the given gap.
+/*!
+  The sequence is generated once per gap; moving it to other rows only
+ rewrites the ACT, RD and PRE instructions of the row slots that changed.
+*/
+class TrcdTemplate{
+
+	public:
+		TrcdTemplate(uint gap);
+		~TrcdTemplate(){ delete iseq; }
+
+		void place(uint slot, uint row);
+		void run(Backend* be, uint rows, uint8_t pattern, const function<void(uint, const ReadError&)>& sink);
+
+	private:
+		uint per_burst; //instructions per burst
+		uint rd; //offset of the RD in a burst
+		uint placed[TRCD_BATCH_ROWS]; //linear row of each slot
+		InstructionSequence* iseq;
+};
+
+TrcdTemplate::TrcdTemplate(uint gap){
+	iseq = new InstructionSequence(MAX_INSTRS);
+
+	rd = gap > 1 ? 2 : 1;
+	per_burst = rd + 4;
+
+	for(uint s = 0; s < TRCD_BATCH_ROWS; s++){
+		placed[s] = 0;
+
+		for(int i = 0; i < NUM_COLS; i+=8){
+			iseq->insert(genACT(0, 0));
+
+			//Wait for the tRCD under test
+			if(gap > 1)
+				iseq->insert(genWAIT(gap - 1));
+
+			iseq->insert(genRD(0, i));
+
+			//Wait for tCL and the burst, and for tRAS if the gap was short
+			iseq->insert(genWAIT(max(6 + 4, SPEC_TRAS_CYCLES - 1 - (int)gap)));
+
+			iseq->insert(genPRE(0, PRE_TYPE::SINGLE));
+
+			//Wait for tRP
+			iseq->insert(genWAIT(SPEC_TRP_CYCLES - 1));
+		}
+	}
+
+	//START Transaction
+	iseq->insert(genEND());
+}
+
+void TrcdTemplate::place(uint slot, uint row){
+	if(placed[slot] == row)
+		return;
+
+	uint bank = row/NUM_ROWS;
+	Instruction* instrs = iseq->instrs + slot*per_burst*BURSTS_PER_ROW;
+	for(int i = 0; i < NUM_COLS; i+=8, instrs += per_burst){
+		instrs[0] = genACT(bank, row%NUM_ROWS);
+		instrs[rd] = genRD(bank, i);
+		instrs[rd + 2] = genPRE(bank, PRE_TYPE::SINGLE);
+	}
+
+	placed[slot] = row;
+}
+
+//! Reads the first \e rows slots and compares them with the pattern.
+/*!
+  \param \e sink receives the slot and every mismatching byte.
+*/
+void TrcdTemplate::run(Backend* be, uint rows, uint8_t pattern, const function<void(uint, const ReadError&)>& sink){
+	uint end = rows*per_burst*BURSTS_PER_ROW;
+	iseq->instrs[end] = genEND();
+	iseq->size = end + 1;
+	if(rows < TRCD_BATCH_ROWS)
+		placed[rows] = NO_ROW; //its ACT has been overwritten
+
+	auto receive = [&](){
+		for(uint s = 0; s < rows; s++)
+			compareRow(be, placed[s]%NUM_ROWS, placed[s]/NUM_ROWS, pattern, [&](const ReadError& e){ sink(s, e); });
+	};
+
+	if(be->chnls.instr != be->chnls.rdback){
+		thread receiver(receive);
+		iseq->execute(be);
+		receiver.join();
+	}
+	else{
+		iseq->execute(be);
+		receive();
+	}
+}
+
+//! Finds the smallest ACT to RD gap every column region of the rows is read
+//correctly with.
+/*!
+  The rows are written with the spec timings and then read back with gaps
+ from SPEC_TRCD_CYCLES down to \e min_cycles, one ACT per burst so that
+ every burst is the first access after the ACT. A region is no longer
+ considered once it fails and the rows are rewritten after a failing gap.
+ TRCD_BATCH_ROWS rows are read per sequence.
+  \param \e trials is the number of times each gap is tested; a region has
+ to pass all of them.
+  \return The latencies of the rows in the order they were visited.
+ LATENCY_UNRELIABLE marks regions that failed with the spec gap.
+*/
+vector<RowLatency> characterizeTrcd(Backend* be, const RowOrder& order, const uint8_t pattern,
+		const uint min_cycles, const uint trials, const bool progress){
+
+	vector<RowLatency> res;
+	res.reserve(order.size());
+
+	TrcdTemplate* templates[SPEC_TRCD_CYCLES + 1] = {};
+	InstructionSequence* iseq = nullptr;
+
+	for(uint first = 0; first < order.size(); first += TRCD_BATCH_ROWS){
+		uint n = min((uint)TRCD_BATCH_ROWS, order.size() - first);
+
+		uint rows[TRCD_BATCH_ROWS];
+		bool alive[TRCD_BATCH_ROWS][LATENCY_REGIONS];
+		for(uint i = 0; i < n; i++){
+			rows[i] = order.at(first + i);
+			res.push_back(RowLatency(order.addr(first + i)));
+			fill(alive[i], alive[i] + LATENCY_REGIONS, true);
+		}
+		RowLatency* lat = &res[first];
+
+		writeRowGroup(be, rows, n, pattern, iseq);
+
+		for(uint gap = SPEC_TRCD_CYCLES; gap >= max(min_cycles, 1u); gap--){
+			TrcdTemplate*& t = templates[gap];
+			if(t == nullptr)
+				t = new TrcdTemplate(gap);
+
+			for(uint i = 0; i < n; i++)
+				t->place(i, rows[i]);
+
+			bool failed = false;
+			turnBus(be, BUSDIR::READ, iseq);
+			for(uint k = 0; k < trials; k++){
+				t->run(be, n, pattern, [&](uint slot, const ReadError& e){
+					alive[slot][e.col/LATENCY_REGION_COLS] = false;
+					failed = true;
+				});
+			}
+
+			bool any = false;
+			for(uint i = 0; i < n; i++){
+				for(uint r = 0; r < LATENCY_REGIONS; r++){
+					if(alive[i][r]){
+						lat[i].cycles[r] = gap;
+						any = true;
+					}
+				}
+			}
+
+			if(!any)
+				break;
+
+			// reads that came too early may have disturbed the data
+			if(failed)
+				writeRowGroup(be, rows, n, pattern, iseq);
+		}
+
+		if(progress){
+			printf("%c[2K\r", 27);
+			printf("Characterized %u of %u rows", first + n, order.size());
+			fflush(stdout);
+		}
+	}
+
+	if(progress)
+		printf("\n");
+
+	for(TrcdTemplate* t : templates)
+		delete t;
+	delete iseq;
+
+	return res;
+}
+
+//! A command of a measurement round and the cycle it is issued at.
+class TimedCmd{
+
+	public:
+		uint cycle;
+		Instruction instr;
+		bool act;
+
+		TimedCmd(uint cycle, Instruction instr, bool act){
+			this->cycle = cycle; this->instr = instr; this->act = act;
+		}
+};
+
+typedef void (*GapCommands)(uint bank, uint row, uint gap, uint start, vector<TimedCmd>& cmds);
+
+//! Restores the row, precharges the bank and activates the row again \e gap
+//cycles after the PRE.
+static void trpCommands(uint bank, uint row, uint gap, uint start, vector<TimedCmd>& cmds){
+	cmds.push_back(TimedCmd(start, genACT(bank, row), true));
+	cmds.push_back(TimedCmd(start + SPEC_TRAS_CYCLES, genPRE(bank, PRE_TYPE::SINGLE), false));
+	cmds.push_back(TimedCmd(start + SPEC_TRAS_CYCLES + gap, genACT(bank, row), true));
+	cmds.push_back(TimedCmd(start + 2*SPEC_TRAS_CYCLES + gap, genPRE(bank, PRE_TYPE::SINGLE), false));
+}
+
+//! Activates the row and precharges the bank \e gap cycles later.
+static void trasCommands(uint bank, uint row, uint gap, uint start, vector<TimedCmd>& cmds){
+	cmds.push_back(TimedCmd(start, genACT(bank, row), true));
+	cmds.push_back(TimedCmd(start + gap, genPRE(bank, PRE_TYPE::SINGLE), false));
+}
+
+//! Appends the commands that measure rows of different banks at once.
+/*!
+  The rows are started the smallest number of cycles apart (at least
+ TRRD_CYCLES) that keeps every command on its own cycle and the ACTs tRRD
+ apart, so the gaps under test are exact.
+  \param \e rows are linear rows of different banks.
+*/
+static void genRound(const vector<uint>& rows, uint gap, GapCommands commands, InstructionSequence* iseq){
+	vector<TimedCmd> cmds;
+	for(uint stride = TRRD_CYCLES; ; stride++){
+		cmds.clear();
+		for(uint k = 0; k < rows.size(); k++)
+			commands(rows[k]/NUM_ROWS, rows[k]%NUM_ROWS, gap, k*stride, cmds);
+
+		stable_sort(cmds.begin(), cmds.end(), [](const TimedCmd& a, const TimedCmd& b){ return a.cycle < b.cycle; });
+
+		bool ok = true;
+		int last_act = -TRRD_CYCLES;
+		for(uint i = 0; i < cmds.size() && ok; i++){
+			if(i > 0 && cmds[i].cycle == cmds[i - 1].cycle)
+				ok = false;
+
+			if(cmds[i].act){
+				if((int)cmds[i].cycle - last_act < TRRD_CYCLES)
+					ok = false;
+				last_act = cmds[i].cycle;
+			}
+		}
+
+		if(ok)
+			break;
+	}
+
+	uint cur = 0;
+	for(const TimedCmd& c : cmds){
+		if(c.cycle > cur)
+			iseq->insert(genWAIT(c.cycle - cur));
+
+		iseq->insert(c.instr);
+		cur = c.cycle + 1;
+	}
+
+	//Wait for tRP
+	iseq->insert(genWAIT(SPEC_TRP_CYCLES - 1));
+}
+
+//! Finds the smallest gap of a timing parameter every column region of the
+//rows keeps its data with.
+/*!
+  For every gap, from \e spec down to \e min_cycles, the rows that still
+ have a passing region are written with the spec timings, measured
+ \e trials times with the commands of the timing parameter and read back
+ with the spec timings. Up to GAP_BATCH_ROWS rows are measured per sequence,
+ rows of different banks in overlapping rounds (see genRound).
+*/
+static vector<RowLatency> characterizeGap(Backend* be, const RowOrder& order, const uint8_t pattern,
+		const uint spec, const uint min_cycles, const uint trials, GapCommands commands, const bool progress){
+
+	vector<RowLatency> res;
+	res.reserve(order.size());
+
+	InstructionSequence* iseq = nullptr;
+	InstructionSequence* measure = new InstructionSequence(MAX_INSTRS);
+
+	for(uint first = 0; first < order.size(); first += GAP_BATCH_ROWS){
+		uint n = min((uint)GAP_BATCH_ROWS, order.size() - first);
+
+		uint rows[GAP_BATCH_ROWS];
+		bool alive[GAP_BATCH_ROWS][LATENCY_REGIONS];
+		unordered_map<uint, uint> slot;
+		for(uint i = 0; i < n; i++){
+			rows[i] = order.at(first + i);
+			res.push_back(RowLatency(order.addr(first + i)));
+			fill(alive[i], alive[i] + LATENCY_REGIONS, true);
+			slot[rows[i]] = i;
+		}
+		RowLatency* lat = &res[first];
+
+		for(uint gap = spec; gap >= max(min_cycles, 1u); gap--){
+			vector<uint> active;
+			for(uint i = 0; i < n; i++)
+				if(any_of(alive[i], alive[i] + LATENCY_REGIONS, [](bool a){ return a; }))
+					active.push_back(rows[i]);
+
+			if(active.empty())
+				break;
+
+			writeRowGroup(be, active.data(), active.size(), pattern, iseq);
+
+			// each row goes to the first round that does not use its bank yet
+			vector<vector<uint>> rounds;
+			for(uint r : active){
+				auto it = find_if(rounds.begin(), rounds.end(), [r](const vector<uint>& round){
+					return none_of(round.begin(), round.end(), [r](uint o){ return o/NUM_ROWS == r/NUM_ROWS; });
+				});
+
+				if(it == rounds.end())
+					rounds.push_back(vector<uint>(1, r));
+				else
+					it->push_back(r);
+			}
+
+			measure->size = 0;
+			for(const vector<uint>& round : rounds)
+				genRound(round, gap, commands, measure);
+
+			//START Transaction
+			measure->insert(genEND());
+
+			for(uint k = 0; k < trials; k++)
+				measure->execute(be);
+
+			readRowGroup(be, active.data(), active.size(), pattern, [&](const ReadError& e){
+				alive[slot[e.bank*NUM_ROWS + e.row]][e.col/LATENCY_REGION_COLS] = false;
+			}, iseq);
+
+			for(uint i = 0; i < n; i++)
+				for(uint r = 0; r < LATENCY_REGIONS; r++)
+					if(alive[i][r])
+						lat[i].cycles[r] = gap;
+		}
+
+		if(progress){
+			printf("%c[2K\r", 27);
+			printf("Characterized %u of %u rows", first + n, order.size());
+			fflush(stdout);
+		}
+	}
+
+	if(progress)
+		printf("\n");
+
+	delete measure;
+	delete iseq;
+
+	return res;
+}
+
+//! Finds the smallest PRE to ACT gap every column region of the rows keeps
+//its data with.
+/*!
+  Each row is activated and precharged with the spec timings and activated
+ again after the gap under test, then read back with the spec timings. Gaps
+ go from SPEC_TRP_CYCLES down to \e min_cycles.
+  \return The latencies of the rows in the order they were visited.
+ LATENCY_UNRELIABLE marks regions that failed with the spec gap.
+*/
+vector<RowLatency> characterizeTrp(Backend* be, const RowOrder& order, const uint8_t pattern,
+		const uint min_cycles, const uint trials, const bool progress){
+
+	return characterizeGap(be, order, pattern, SPEC_TRP_CYCLES, min_cycles, trials, trpCommands, progress);
+}
+
+//! Finds the smallest ACT to PRE gap every column region of the rows keeps
+//its data with.
+/*!
+  Each row is activated and precharged after the gap under test, then read
+ back with the spec timings. Gaps go from SPEC_TRAS_CYCLES down to
+ \e min_cycles.
+  \return The latencies of the rows in the order they were visited.
+ LATENCY_UNRELIABLE marks regions that failed with the spec gap.
+*/
+vector<RowLatency> characterizeTras(Backend* be, const RowOrder& order, const uint8_t pattern,
+		const uint min_cycles, const uint trials, const bool progress){
+
+	return characterizeGap(be, order, pattern, SPEC_TRAS_CYCLES, min_cycles, trials, trasCommands, progress);
+}
+
+//! Writes or reads one burst of the row and closes the row \e gap cycles
+//after the WR or RD.
+/*!
+  Without auto-precharge the gap is the one to the PRE, and the WR or RD is
+ issued late enough after the ACT for the PRE to meet tRAS. With
+ auto-precharge the gap is the one to the next ACT of the row, which the
+ DRAM has to have precharged by then.
+  \return The number of instructions written to \e out.
+*/
+static uint recoveryBurst(bool write, AUTO_PRECHARGE ap, uint gap, uint8_t pattern, uint bank, uint row, uint col,
+		Instruction* out){
+
+	uint n = 0;
+	out[n++] = genACT(bank, row);
+
+	//Wait for tRCD, and for tRAS if the gap to the PRE is short
+	out[n++] = genWAIT(ap == AUTO_PRECHARGE::AP ? SPEC_TRCD_CYCLES - 1 :
+			max(SPEC_TRCD_CYCLES - 1, SPEC_TRAS_CYCLES - 1 - (int)gap));
+
+	out[n++] = write ? genWR(bank, col, pattern, ap) : genRD(bank, col, ap);
+
+	//Wait for the tWR or tRTP under test
+	if(gap > 1)
+		out[n++] = genWAIT(gap - 1);
+
+	if(ap == AUTO_PRECHARGE::AP){
+		out[n++] = genACT(bank, row);
+
+		//Wait for tRAS
+		out[n++] = genWAIT(SPEC_TRAS_CYCLES - 1);
+	}
+
+	out[n++] = genPRE(bank, PRE_TYPE::SINGLE);
+
+	//Wait for tRP
+	out[n++] = genWAIT(SPEC_TRP_CYCLES - 1);
+
+	return n;
+}
+
+//! Accesses every burst of as many rows as fit in a sequence, each burst
+//with its own ACT and the gap under test (see recoveryBurst).
+/*!
+  The sequence is generated once per gap; moving it to other rows only
+ rewrites the instructions of the row slots that changed.
+*/
+class RecoveryTemplate{
+
+	public:
+		RecoveryTemplate(bool write, AUTO_PRECHARGE ap, uint gap, uint8_t pattern);
+		~RecoveryTemplate(){ delete iseq; }
+
+		static uint slotCount(bool write, AUTO_PRECHARGE ap, uint gap);
+
+		void place(uint slot, uint row);
+		void run(Backend* be, uint rows, const function<void(uint, const ReadError&)>& sink);
+
+		uint slots; //rows per sequence
+
+	private:
+		bool write;
+		AUTO_PRECHARGE ap;
+		uint gap;
+		uint8_t pattern;
+		uint per_burst; //instructions per burst
+		vector<uint> placed; //linear row of each slot
+		InstructionSequence* iseq;
+};
+
+RecoveryTemplate::RecoveryTemplate(bool write, AUTO_PRECHARGE ap, uint gap, uint8_t pattern){
+	this->write = write;
+	this->ap = ap;
+	this->gap = gap;
+	this->pattern = pattern;
+
+	Instruction burst[16];
+	per_burst = recoveryBurst(write, ap, gap, pattern, 0, 0, 0, burst);
+	slots = slotCount(write, ap, gap);
+	placed.assign(slots, NO_ROW);
+
+	iseq = new InstructionSequence(MAX_INSTRS);
+	iseq->size = slots*per_burst*BURSTS_PER_ROW;
+	for(uint s = 0; s < slots; s++)
+		place(s, 0);
+
+	//START Transaction
+	iseq->insert(genEND());
+}
+
+//! Rows that fit in a sequence with the given gap.
+uint RecoveryTemplate::slotCount(bool write, AUTO_PRECHARGE ap, uint gap){
+	Instruction burst[16];
+	return (MAX_INSTRS - 1)/(recoveryBurst(write, ap, gap, 0, 0, 0, 0, burst)*BURSTS_PER_ROW);
+}
+
+void RecoveryTemplate::place(uint slot, uint row){
+	if(placed[slot] == row)
+		return;
+
+	Instruction* instrs = iseq->instrs + slot*per_burst*BURSTS_PER_ROW;
+	for(int i = 0; i < NUM_COLS; i+=8, instrs += per_burst)
+		recoveryBurst(write, ap, gap, pattern, row/NUM_ROWS, row%NUM_ROWS, i, instrs);
+
+	placed[slot] = row;
+}
+
+//! Runs the first \e rows slots. Reads are compared with the pattern.
+/*!
+  \param \e sink receives the slot and every mismatching byte.
+*/
+void RecoveryTemplate::run(Backend* be, uint rows, const function<void(uint, const ReadError&)>& sink){
+	uint end = rows*per_burst*BURSTS_PER_ROW;
+	iseq->instrs[end] = genEND();
+	iseq->size = end + 1;
+	if(rows < slots)
+		placed[rows] = NO_ROW; //its ACT has been overwritten
+
+	auto receive = [&](){
+		for(uint s = 0; s < rows; s++)
+			compareRow(be, placed[s]%NUM_ROWS, placed[s]/NUM_ROWS, pattern, [&](const ReadError& e){ sink(s, e); });
+	};
+
+	if(write)
+		iseq->execute(be);
+	else if(be->chnls.instr != be->chnls.rdback){
+		thread receiver(receive);
+		iseq->execute(be);
+		receiver.join();
+	}
+	else{
+		iseq->execute(be);
+		receive();
+	}
+}
+
+//! Returns the spec gap of the tWR or tRTP harness: the gap to the PRE, or
+//with auto-precharge the gap to the next ACT (tDAL after a WR).
+uint recoverySpec(const bool write, const AUTO_PRECHARGE ap){
+	uint gap = write ? SPEC_TWR_CYCLES : SPEC_TRTP_CYCLES;
+	if(ap == AUTO_PRECHARGE::NO_AP)
+		return gap;
+
+	// a RD with auto-precharge still has to keep the row open for tRAS
+	if(!write)
+		gap = max(gap, (uint)(SPEC_TRAS_CYCLES - SPEC_TRCD_CYCLES));
+
+	return gap + SPEC_TRP_CYCLES;
+}
+
+//! Finds the smallest WR or RD to PRE gap every column region of the rows
+//works with.
+/*!
+  For every gap, from recoverySpec down to \e min_cycles, the rows are
+ accessed with RecoveryTemplate, which batches as many rows as fit in a
+ sequence. Written rows are first filled with the inverted pattern, so that
+ a write that does not complete leaves old data behind, and read back with
+ the spec timings. Reads are checked as they are returned and, with
+ auto-precharge, the rows are read back with the spec timings as well, as
+ activating them too early corrupts them. A region is no longer considered
+ once it fails.
+*/
+static vector<RowLatency> characterizeRecovery(Backend* be, const RowOrder& order, const uint8_t pattern,
+		const bool write, const AUTO_PRECHARGE ap, const uint min_cycles, const uint trials, const bool progress){
+
+	vector<RowLatency> res;
+	res.reserve(order.size());
+
+	uint spec = recoverySpec(write, ap);
+	vector<RecoveryTemplate*> templates(spec + 1, nullptr);
+	InstructionSequence* iseq = nullptr;
+
+	uint batch = RecoveryTemplate::slotCount(write, ap, spec);
+	vector<uint> rows(batch);
+	vector<array<bool, LATENCY_REGIONS>> alive(batch);
+	unordered_map<uint, uint> slot;
+
+	for(uint first = 0; first < order.size(); first += batch){
+		uint n = min(batch, order.size() - first);
+
+		slot.clear();
+		for(uint i = 0; i < n; i++){
+			rows[i] = order.at(first + i);
+			res.push_back(RowLatency(order.addr(first + i)));
+			alive[i].fill(true);
+			slot[rows[i]] = i;
+		}
+		RowLatency* lat = &res[first];
+
+		auto kill = [&](const ReadError& e){ alive[slot[e.bank*NUM_ROWS + e.row]][e.col/LATENCY_REGION_COLS] = false; };
+
+		bool dirty = true; //the rows do not hold the pattern
+		for(uint gap = spec; gap >= max(min_cycles, 1u); gap--){
+			RecoveryTemplate*& t = templates[gap];
+			if(t == nullptr)
+				t = new RecoveryTemplate(write, ap, gap, pattern);
+
+			for(uint i = 0; i < n; i++)
+				t->place(i, rows[i]);
+
+			bool failed = false;
+			auto sink = [&](const ReadError& e){ kill(e); failed = true; };
+
+			for(uint k = 0; k < trials; k++){
+				if(write){
+					writeRowGroup(be, rows.data(), n, (uint8_t)~pattern, iseq);
+					t->run(be, n, nullptr);
+					readRowGroup(be, rows.data(), n, pattern, sink, iseq);
+					continue;
+				}
+
+				if(dirty)
+					writeRowGroup(be, rows.data(), n, pattern, iseq);
+				dirty = false;
+
+				turnBus(be, BUSDIR::READ, iseq);
+				t->run(be, n, [&](uint, const ReadError& e){ sink(e); });
+
+				if(ap == AUTO_PRECHARGE::AP)
+					readRowGroup(be, rows.data(), n, pattern, sink, iseq);
+
+				dirty = failed;
+			}
+
+			bool any = false;
+			for(uint i = 0; i < n; i++){
+				for(uint r = 0; r < LATENCY_REGIONS; r++){
+					if(alive[i][r]){
+						lat[i].cycles[r] = gap;
+						any = true;
+					}
+				}
+			}
+
+			if(!any)
+				break;
+		}
+
+		if(progress){
+			printf("%c[2K\r", 27);
+			printf("Characterized %u of %u rows", first + n, order.size());
+			fflush(stdout);
+		}
+	}
+
+	if(progress)
+		printf("\n");
+
+	for(RecoveryTemplate* t : templates)
+		delete t;
+	delete iseq;
+
+	return res;
+}
+
+//! Finds the smallest WR to PRE gap (CWL, the burst and tWR) every column
+//region of the rows is written correctly with.
+/*!
+  With auto-precharge, the WR precharges the row itself after tWR and the
+ gap is the one from the WR to the next ACT of the row (tDAL).
+  \return The latencies of the rows in the order they were visited.
+ LATENCY_UNRELIABLE marks regions that failed with the spec gap.
+*/
+vector<RowLatency> characterizeTwr(Backend* be, const RowOrder& order, const uint8_t pattern,
+		const AUTO_PRECHARGE ap, const uint min_cycles, const uint trials, const bool progress){
+
+	return characterizeRecovery(be, order, pattern, true, ap, min_cycles, trials, progress);
+}
+
+//! Finds the smallest RD to PRE gap (tRTP) every column region of the rows
+//is read correctly with.
+/*!
+  With auto-precharge, the gap is the one from the RD to the next ACT of
+ the row.
+  \return The latencies of the rows in the order they were visited.
+ LATENCY_UNRELIABLE marks regions that failed with the spec gap.
+*/
+vector<RowLatency> characterizeTrtp(Backend* be, const RowOrder& order, const uint8_t pattern,
+		const AUTO_PRECHARGE ap, const uint min_cycles, const uint trials, const bool progress){
+
+	return characterizeRecovery(be, order, pattern, false, ap, min_cycles, trials, progress);
+}
@@ -0,0 +1,63 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <vector>
+#include "rowops.h"
+#include "roworder.h"
+
+// ACT to RD, PRE to ACT and ACT to PRE gaps, in cycles, of our sequences
+//(15, 15 and 35 ns)
+#define SPEC_TRCD_CYCLES 6
+#define SPEC_TRP_CYCLES 6
+#define SPEC_TRAS_CYCLES 14
+
+// WR to PRE and RD to PRE gaps, in cycles: CWL (5), the burst (4) and tWR
+//(6), and tRTP (4)
+#define SPEC_TWR_CYCLES 15
+#define SPEC_TRTP_CYCLES 4
+
+// column regions a row is characterized in
+#define LATENCY_REGIONS 8
+#define LATENCY_REGION_COLS (NUM_COLS/LATENCY_REGIONS)
+
+// latency of a region that failed even with the spec timing
+#define LATENCY_UNRELIABLE 0xFF
+
+//! Smallest latency, in cycles, each column region of a row worked with.
+class RowLatency{
+
+	public:
+		DramAddr addr;
+		uint8_t cycles[LATENCY_REGIONS];
+
+		RowLatency() : RowLatency(DramAddr()){}
+		RowLatency(const DramAddr& addr){
+			this->addr = addr;
+			for(uint i = 0; i < LATENCY_REGIONS; i++)
+				cycles[i] = LATENCY_UNRELIABLE;
+		}
+
+		//! The latency the whole row works with.
+		uint8_t max() const {
+			uint8_t m = 0;
+			for(uint i = 0; i < LATENCY_REGIONS; i++)
+				m = cycles[i] > m ? cycles[i] : m;
+			return m;
+		}
+};
+
+std::vector<RowLatency> characterizeTrcd(Backend* be, const RowOrder& order, const uint8_t pattern,
+		const uint min_cycles = 1, const uint trials = 1, const bool progress = false);
+std::vector<RowLatency> characterizeTrp(Backend* be, const RowOrder& order, const uint8_t pattern,
+		const uint min_cycles = 1, const uint trials = 1, const bool progress = false);
+std::vector<RowLatency> characterizeTras(Backend* be, const RowOrder& order, const uint8_t pattern,
+		const uint min_cycles = 1, const uint trials = 1, const bool progress = false);
+std::vector<RowLatency> characterizeTwr(Backend* be, const RowOrder& order, const uint8_t pattern,
+		const AUTO_PRECHARGE ap = AUTO_PRECHARGE::NO_AP, const uint min_cycles = 1, const uint trials = 1,
+		const bool progress = false);
+std::vector<RowLatency> characterizeTrtp(Backend* be, const RowOrder& order, const uint8_t pattern,
+		const AUTO_PRECHARGE ap = AUTO_PRECHARGE::NO_AP, const uint min_cycles = 1, const uint trials = 1,
+		const bool progress = false);
+uint recoverySpec(const bool write, const AUTO_PRECHARGE ap);
+
+#endif //LATENCY_H
@@ -0,0 +1,107 @@
+#include "patterns.h"
+#include "splitmix.h"
+#include <string.h>
+#include <unordered_set>
+
+using namespace std;
+
+static const char* pattern_names[NUM_DATA_PATTERNS] = {"all0", "all1", "checkerboard", "rowstripe", "colstripe",
+	"walking1", "random"};
+
+const char* patternName(DATA_PATTERN p){
+	return pattern_names[(int)p];
+}
+
+//! Looks a pattern up by its patternName.
+bool parsePattern(const string& name, DATA_PATTERN& p){
+	for(int i = 0; i < NUM_DATA_PATTERNS; i++){
+		if(name == pattern_names[i]){
+			p = (DATA_PATTERN)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+//! Fills \e bursts (BURSTS_PER_ROW bytes) with the bytes of the pattern in
+//the given row.
+void patternBursts(DATA_PATTERN p, uint bank, uint row, uint64_t seed, uint8_t* bursts){
+	switch(p){
+		case DATA_PATTERN::ALL_0:
+			memset(bursts, 0x00, BURSTS_PER_ROW);
+			break;
+		case DATA_PATTERN::ALL_1:
+			memset(bursts, 0xff, BURSTS_PER_ROW);
+			break;
+		case DATA_PATTERN::CHECKERBOARD:
+			memset(bursts, row % 2 ? 0x55 : 0xaa, BURSTS_PER_ROW);
+			break;
+		case DATA_PATTERN::ROW_STRIPE:
+			memset(bursts, row % 2 ? 0x00 : 0xff, BURSTS_PER_ROW);
+			break;
+		case DATA_PATTERN::COL_STRIPE:
+			memset(bursts, 0xaa, BURSTS_PER_ROW);
+			break;
+		case DATA_PATTERN::WALKING_1:
+			for(uint i = 0; i < BURSTS_PER_ROW; i++)
+				bursts[i] = 1 << ((row + i) % 8);
+			break;
+		case DATA_PATTERN::RANDOM:{
+			uint64_t x = seed ^ (((uint64_t)bank << 32) | row);
+			for(uint i = 0; i < BURSTS_PER_ROW; i += 8){
+				// 8 bursts per output
+				uint64_t z = splitmix64(x);
+				memcpy(bursts + i, &z, 8);
+			}
+			break;
+		}
+	}
+}
+
+//! Tests several data patterns in a single pipelined retention test.
+/*!
+  Every row gets one of the patterns, by bank or by row group of
+ PATTERN_GROUP_ROWS rows (see PATTERN_SPLIT), and the rows are tested at
+ the retention time with sweepRetention, so all patterns share one pass.
+ Splitting by bank keeps rows of different patterns from being neighbours.
+  \param \e sink receives every mismatching byte with the pattern of its row.
+  \param \e seed fixes the bytes of DATA_PATTERN::RANDOM.
+  \return The failures of each pattern, in the order of \e patterns. Nothing
+ is tested if \e patterns is empty.
+*/
+vector<PatternStats> testPatterns(Backend* be, const int retention, const RowOrder& order,
+		const vector<DATA_PATTERN>& patterns, const PATTERN_SPLIT split, const PatternSink& sink,
+		const uint64_t seed, const bool progress){
+
+	vector<PatternStats> stats;
+	if(patterns.empty())
+		return stats;
+
+	for(DATA_PATTERN p : patterns)
+		stats.push_back(PatternStats(p));
+
+	auto index = [&](uint r){
+		return (split == PATTERN_SPLIT::BANK ? r/NUM_ROWS : (r%NUM_ROWS)/PATTERN_GROUP_ROWS) % patterns.size();
+	};
+
+	for(uint i = 0; i < order.size(); i++)
+		stats[index(order.at(i))].rows++;
+
+	unordered_set<uint> failing;
+	RowPattern pattern = [&](uint r, uint8_t* bursts){
+		patternBursts(patterns[index(r)], r/NUM_ROWS, r%NUM_ROWS, seed, bursts);
+	};
+
+	sweepRetention(be, vector<int>(1, retention), order, pattern, [&](int, const ReadError& e){
+		uint r = e.bank*NUM_ROWS + e.row;
+		PatternStats& st = stats[index(r)];
+		st.errors++;
+		st.flips += __builtin_popcount(e.data ^ e.expected);
+		if(failing.insert(r).second)
+			st.failing_rows++;
+
+		sink(st.pattern, e);
+	}, SWEEP_GROUP_ROWS, progress);
+
+	return stats;
+}
@@ -0,0 +1,59 @@
+#ifndef PATTERNS_H
+#define PATTERNS_H
+
+#include <string>
+#include <vector>
+#include "sweep.h"
+
+// rows of a bank that get the same pattern with PATTERN_SPLIT::ROW_GROUP
+#define PATTERN_GROUP_ROWS 64
+
+// genWR repeats an 8-bit pattern over the burst, so every pattern is a byte
+//per (row, burst)
+enum class DATA_PATTERN {
+	ALL_0 = 0,
+	ALL_1 = 1,
+	CHECKERBOARD = 2, //0xaa and 0x55 in alternate rows
+	ROW_STRIPE = 3, //0xff and 0x00 in alternate rows
+	COL_STRIPE = 4, //0xaa in every row
+	WALKING_1 = 5, //a single 1 that moves one bit per burst and row
+	RANDOM = 6 //a random byte per burst, fixed by the seed
+};
+
+#define NUM_DATA_PATTERNS 7
+
+//! How the rows are shared among the patterns of a suite.
+enum class PATTERN_SPLIT {
+	BANK = 0, //pattern i in banks i, i + n, ...
+	ROW_GROUP = 1 //pattern i in row groups i, i + n, ... of every bank
+};
+
+//! Failures of the rows that held one pattern.
+class PatternStats{
+
+	public:
+		DATA_PATTERN pattern;
+		uint64_t rows;
+		uint64_t errors; //mismatching bytes
+		uint64_t flips; //bits
+		uint64_t failing_rows;
+
+		PatternStats() : PatternStats(DATA_PATTERN::ALL_0){}
+		PatternStats(DATA_PATTERN pattern){ this->pattern = pattern; rows = 0; errors = 0; flips = 0; failing_rows = 0; }
+
+		//! Fraction of the bits of the rows that flipped.
+		double rate() const { return rows ? (double)flips/(rows*NUM_COLS*64) : 0; }
+};
+
+//! Receives the errors of testPatterns with the pattern of the row.
+typedef std::function<void(DATA_PATTERN pattern, const ReadError&)> PatternSink;
+
+const char* patternName(DATA_PATTERN p);
+bool parsePattern(const std::string& name, DATA_PATTERN& p);
+void patternBursts(DATA_PATTERN p, uint bank, uint row, uint64_t seed, uint8_t* bursts);
+
+std::vector<PatternStats> testPatterns(Backend* be, const int retention, const RowOrder& order,
+		const std::vector<DATA_PATTERN>& patterns, const PATTERN_SPLIT split, const PatternSink& sink,
+		const uint64_t seed = 1, const bool progress = false);
+
+#endif //PATTERNS_H
@@ -0,0 +1,93 @@
+#include "refresh.h"
+#include "cellmap.h"
+#include "fill.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <algorithm>
+
+using namespace std;
+
+//! Measures the failures of the rows with the refresh engine of the board
+//running at multiples of the nominal tREFI.
+/*!
+  For every multiplier, tREFI and tRFC are programmed with genREF_CONFIG and
+ the rows are kept filled with the pattern while the board refreshes them.
+ The rows are split into \e slices slices that are written back to back and
+ then scanned, each once it has aged for REFRESH_DWELL_WINDOWS refresh
+ windows, and written again for the next pass. Scanning and writing a slice
+ overlaps with the aging of the others, so the run only waits when a slice
+ takes less time than the windows. The refresh engine is turned off (tREFI
+ 0) at the end.
+  \param \e sink receives every mismatching byte with its multiplier.
+  \return The failures at every multiplier, in the order of \e multipliers.
+*/
+vector<RefreshStats> sweepRefresh(Backend* be, const vector<uint>& multipliers,
+		const RowOrder& order, const uint8_t pattern, const RefreshSink& sink, const uint passes,
+		const uint slices, const bool progress){
+
+	uint n = max(1u, min(slices, order.size()));
+	vector<SliceOrder> parts;
+	for(uint s = 0; s < n; s++)
+		parts.push_back(SliceOrder(order, (uint64_t)order.size()*s/n, (uint64_t)order.size()*(s + 1)/n));
+
+	vector<RefreshStats> stats;
+	vector<uint64_t> deadlines(n);
+	DeadlineScheduler sched;
+
+	for(uint m : multipliers){
+		RefreshStats st(m, SPEC_TREFI_TICKS*m);
+		st.passes = passes;
+		uint64_t dwell = (uint64_t)(REFRESH_DWELL_WINDOWS*st.windowMs()*1e6);
+		CellBitmap cells;
+
+		ErrorSink scan_sink = [&](const ReadError& e){
+			st.flips += __builtin_popcount(e.data ^ e.expected);
+			cells.insert(e);
+			sink(m, e);
+		};
+
+		setRefreshConfig(be, st.trefi, SPEC_TRFC_CYCLES);
+		uint64_t start = DeadlineScheduler::now();
+
+		for(uint s = 0; s < n; s++){
+			fill(be, parts[s], pattern);
+			deadlines[s] = DeadlineScheduler::now() + dwell;
+		}
+
+		for(uint p = 0; p < passes; p++){
+			for(uint s = 0; s < n; s++){
+				uint64_t now = DeadlineScheduler::now();
+				if(deadlines[s] > now){
+					st.wait_ms += (deadlines[s] - now)/1e6;
+					sched.waitUntil(deadlines[s]);
+				}
+
+				ScanStats ss = scanRows(be, parts[s], pattern, scan_sink);
+				st.rows += ss.rows;
+				st.lost += ss.lost;
+				st.errors += ss.errors;
+
+				if(p + 1 < passes){
+					fill(be, parts[s], pattern);
+					deadlines[s] = DeadlineScheduler::now() + dwell;
+				}
+
+				if(progress){
+					printf("%c[2K\r", 27);
+					printf("tREFI x%u: scanned %u of %u slices", m, p*n + s + 1, passes*n);
+					fflush(stdout);
+				}
+			}
+		}
+
+		st.cells = cells.cardinality();
+		st.ms = (DeadlineScheduler::now() - start)/1e6;
+		stats.push_back(st);
+	}
+
+	if(progress)
+		printf("\n");
+
+	setRefreshConfig(be, 0, SPEC_TRFC_CYCLES);
+	return stats;
+}
@@ -0,0 +1,49 @@
+#ifndef REFRESH_H
+#define REFRESH_H
+
+#include <vector>
+#include "scan.h"
+
+// parts of the rows that are written, left to age and scanned in turn
+#define REFRESH_SLICES 8
+
+// refresh windows a slice ages for, so that every row waits a full window
+//between two refreshes whenever it was written
+#define REFRESH_DWELL_WINDOWS 2
+
+//! Receives the errors of sweepRefresh with the tREFI multiplier they were found at.
+typedef std::function<void(uint multiplier, const ReadError&)> RefreshSink;
+
+//! Failures of the rows at one refresh interval.
+class RefreshStats{
+
+	public:
+		uint multiplier; //of the nominal tREFI
+		uint trefi; //in REF_TICK_NS ticks
+		uint passes;
+		uint64_t rows; //scanned, over all passes
+		uint64_t lost; //rows not verified, see ScanStats
+		uint64_t errors; //mismatching bytes
+		uint64_t flips; //bits
+		uint64_t cells; //distinct failing cells
+		double ms;
+		double wait_ms; //no slice was due to be scanned
+
+		RefreshStats() : RefreshStats(0, 0){}
+		RefreshStats(uint multiplier, uint trefi){
+			this->multiplier = multiplier; this->trefi = trefi; passes = 0;
+			rows = 0; lost = 0; errors = 0; flips = 0; cells = 0; ms = 0; wait_ms = 0;
+		}
+
+		//! Time between two refreshes of a row.
+		double windowMs() const { return (double)REFS_PER_WINDOW*trefi*REF_TICK_NS/1e6; }
+
+		//! Fraction of the bits read back that flipped.
+		double rate() const { return rows > lost ? (double)flips/((rows - lost)*NUM_COLS*64) : 0; }
+};
+
+std::vector<RefreshStats> sweepRefresh(Backend* be, const std::vector<uint>& multipliers,
+		const RowOrder& order, const uint8_t pattern, const RefreshSink& sink, const uint passes = 1,
+		const uint slices = REFRESH_SLICES, const bool progress = false);
+
+#endif //REFRESH_H
@@ -0,0 +1,345 @@
+#include "retention.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <cmath>
+#include <thread>
+
+//! Switches the bus to write mode and writes the pattern to the rows.
+/*!
+  \param \e rows are linear row numbers (bank*NUM_ROWS + row).
+*/
+void writeRowGroup(Backend* be, const uint* rows, const uint num_rows, const uint8_t pattern,
+		InstructionSequence*& iseq){
+
+	// Switch the memory bus to write mode
+	turnBus(be, BUSDIR::WRITE, iseq);
+
+	// We write to a chunk of rows successively
+	for(uint i = 0; i < num_rows; i++)
+		writeRow(be, rows[i]%NUM_ROWS, rows[i]/NUM_ROWS, pattern, iseq);
+}
+
+//! Switches the bus to read mode and checks the rows against the pattern.
+/*!
+  With separate instruction and read back channels, read back data is
+ received on a separate thread while the read instructions are being sent.
+*/
+void readRowGroup(Backend* be, const uint* rows, const uint num_rows, const uint8_t pattern,
+		const ErrorSink& sink, InstructionSequence*& iseq){
+
+	// Switch the memory bus to read mode
+	turnBus(be, BUSDIR::READ, iseq);
+
+	// Read the data back and compare
+	if(be->chnls.instr != be->chnls.rdback){
+		std::thread receiver([=, &sink](){
+			for(uint i = 0; i < num_rows; i++)
+				compareRow(be, rows[i]%NUM_ROWS, rows[i]/NUM_ROWS, pattern, sink);
+		});
+
+		for(uint i = 0; i < num_rows; i++)
+			readRow(be, rows[i]%NUM_ROWS, rows[i]/NUM_ROWS, iseq);
+
+		receiver.join();
+	}
+	else{
+		for(uint i = 0; i < num_rows; i++)
+			readAndCompareRow(be, rows[i]%NUM_ROWS, rows[i]/NUM_ROWS, pattern, iseq, sink);
+	}
+}
+
+//! Writes a pattern per row to the rows of the group.
+void writeRowGroup(Backend* be, const uint* rows, const uint num_rows, const RowPattern& pattern,
+		InstructionSequence*& iseq){
+
+	uint8_t bursts[BURSTS_PER_ROW];
+	turnBus(be, BUSDIR::WRITE, iseq);
+
+	for(uint i = 0; i < num_rows; i++){
+		pattern(rows[i], bursts);
+		writeRow(be, rows[i]%NUM_ROWS, rows[i]/NUM_ROWS, bursts, iseq);
+	}
+}
+
+//! Checks the rows of the group against the pattern of each row.
+void readRowGroup(Backend* be, const uint* rows, const uint num_rows, const RowPattern& pattern,
+		const ErrorSink& sink, InstructionSequence*& iseq){
+
+	turnBus(be, BUSDIR::READ, iseq);
+
+	if(be->chnls.instr != be->chnls.rdback){
+		std::thread receiver([=, &pattern, &sink](){
+			uint8_t bursts[BURSTS_PER_ROW];
+			for(uint i = 0; i < num_rows; i++){
+				pattern(rows[i], bursts);
+				compareRow(be, rows[i]%NUM_ROWS, rows[i]/NUM_ROWS, bursts, sink);
+			}
+		});
+
+		for(uint i = 0; i < num_rows; i++)
+			readRow(be, rows[i]%NUM_ROWS, rows[i]/NUM_ROWS, iseq);
+
+		receiver.join();
+	}
+	else{
+		uint8_t bursts[BURSTS_PER_ROW];
+		for(uint i = 0; i < num_rows; i++){
+			pattern(rows[i], bursts);
+			readRow(be, rows[i]%NUM_ROWS, rows[i]/NUM_ROWS, iseq);
+			compareRow(be, rows[i]%NUM_ROWS, rows[i]/NUM_ROWS, bursts, sink);
+		}
+	}
+}
+
+//! Writes the rows, waits for the retention time and checks them.
+/*!
+  Rows age longer than the retention time if writing the group takes longer
+ than that, use ThroughputModel::groupSize to size the group.
+  \param \e waits, if given, waits for the retention time, so that its
+ stats() include how late the read back started.
+  \param \e model, if given, paces the rows: row i is written i row periods
+ (see ThroughputModel::rowPeriod) after the first one and read the same
+ time after the first read, so the faster of writing and reading does not
+ make the rows age differently. The model is updated with the measured
+ write and read times, without the pacing.
+*/
+void testRetentionGroup(Backend* be, const int retention, const uint* rows, const uint num_rows,
+		const uint8_t pattern, const ErrorSink& sink, InstructionSequence*& iseq,
+		ThroughputModel* model, DeadlineScheduler* waits){
+
+	DeadlineScheduler sched;
+	if(!waits)
+		waits = &sched;
+	uint64_t start = DeadlineScheduler::now();
+
+	if(!model){
+		writeRowGroup(be, rows, num_rows, pattern, iseq);
+
+		// wait for the specified retention time (retention)
+		waits->waitUntil(start + retention*1000000ULL);
+		readRowGroup(be, rows, num_rows, pattern, sink, iseq);
+		return;
+	}
+
+	uint64_t period = (uint64_t)(model->rowPeriod()*1e6);
+	uint64_t write_ns = 0, read_ns = 0;
+
+	turnBus(be, BUSDIR::WRITE, iseq);
+	for(uint i = 0; i < num_rows; i++){
+		sched.waitUntil(start + i*period);
+
+		uint64_t t = DeadlineScheduler::now();
+		writeRow(be, rows[i]%NUM_ROWS, rows[i]/NUM_ROWS, pattern, iseq);
+		write_ns += DeadlineScheduler::now() - t;
+	}
+
+	// wait for the specified retention time (retention), or for the last
+	//write if the group takes longer
+	waits->waitUntil(start + retention*1000000ULL);
+	uint64_t read_start = DeadlineScheduler::now();
+
+	turnBus(be, BUSDIR::READ, iseq);
+	for(uint i = 0; i < num_rows; i++){
+		sched.waitUntil(read_start + i*period);
+
+		uint64_t t = DeadlineScheduler::now();
+		readAndCompareRow(be, rows[i]%NUM_ROWS, rows[i]/NUM_ROWS, pattern, iseq, sink);
+		read_ns += DeadlineScheduler::now() - t;
+	}
+
+	model->observeWrite(num_rows, write_ns/1e6);
+	model->observeRead(num_rows, read_ns/1e6);
+}
+
+//! Runs a test to check the DRAM cells against the given retention time.
+/*!
+  \param \e be is the board to test.
+  \param \e retention is the retention time in milliseconds to test.
+  \param \e first is the first row to test. Rows are visited in row-major
+ order within bank-major order.
+  \param \e num_rows is the number of rows to test (capped at the end of
+ the DIMM).
+  \param \e pattern is the data pattern that we write to the DRAM.
+  \param \e sink receives every mismatching byte.
+  \param \e progress prints the row that is about to be tested.
+  \param \e model sizes the row groups and is kept up to date with the
+ measured write and read times. If not given, a model is calibrated on the
+ first rows.
+  \param \e ckpt, if given, skips the rows it has completed and records the
+ rows that this run completes.
+*/
+void testRetention(Backend* be, const int retention, const DramAddr& first, const uint num_rows,
+		const uint8_t pattern, const ErrorSink& sink, const bool progress, ThroughputModel* model,
+		Checkpoint* ckpt){
+
+	testRetention(be, retention, RangeOrder(first, num_rows), pattern, sink, progress, model, ckpt);
+}
+
+//! Runs the retention test on the rows of \e order, in that order.
+/*!
+  Consecutive rows of the order form the row groups.
+*/
+void testRetention(Backend* be, const int retention, const RowOrder& order,
+		const uint8_t pattern, const ErrorSink& sink, const bool progress, ThroughputModel* model,
+		Checkpoint* ckpt){
+
+	InstructionSequence* iseq = nullptr; // we temporarily store (before sending them to the FPGA) the generated instructions here
+
+	if(order.size() == 0)
+		return;
+
+	ThroughputModel local;
+	if(!model){
+		model = &local;
+		model->calibrate(be, order.addr(0), pattern);
+	}
+
+	if(progress)
+		printf("Row write: %.3f ms, row read: %.3f ms \n", model->write_ms, model->read_ms);
+
+	std::vector<uint> rows;
+	DeadlineScheduler waits;
+
+	if(progress)
+		printf("\n");
+
+	for(uint i = 0; i < order.size();){ //continue until we cover the entire order
+		uint group_size = model->groupSize(retention); //number of rows to be written in a single iteration
+		if(rows.size() < group_size)
+			rows.resize(group_size);
+
+		uint n = 0;
+		for(; n < group_size && i < order.size(); i++){
+			uint row = order.at(i);
+			if(ckpt && ckpt->isDone(retention, row))
+				continue;
+
+			rows[n++] = row;
+		}
+
+		if(n == 0)
+			break;
+
+		if(progress){
+			//print the number of the row that we are about to test
+			printf("%c[2K\r", 27);
+			printf("Current Bank: %d, Row: %d", rows[0]/NUM_ROWS, rows[0]%NUM_ROWS);
+			fflush(stdout);
+		}
+
+		testRetentionGroup(be, retention, rows.data(), n, pattern, sink, iseq, model, &waits);
+
+		if(ckpt)
+			ckpt->complete(retention, rows.data(), n);
+	}
+
+	if(ckpt)
+		ckpt->sync();
+
+	if(progress){
+		WakeupStats st = waits.stats();
+		printf("\n");
+		printf("%llu retention waits, read back late by %.3f ms on average, %.3f ms at most \n",
+				(unsigned long long)st.wakeups, st.meanLateNs()/1e6, st.max_late_ns/1e6);
+	}
+
+	delete iseq;
+}
+
+//! Finds the retention time of every row with a search over retention times.
+/*!
+  The probed retention times are \e levels points spaced geometrically
+ between \e min_ms and \e max_ms. All rows are first checked at \e max_ms;
+ the rows that pass are done, and every row that fails continues with a
+ binary search over the shorter times. The rows that wait for the same
+ retention time in a pass are tested together, so profiling takes about
+ 1 + log2(levels) passes over the failing rows instead of \e levels passes
+ over the DIMM.
+  \param \e model sizes the row groups, as in testRetention.
+  \return The retention time bounds of every row, indexed from \e first.
+*/
+std::vector<RowRetention> profileRetention(Backend* be, const DramAddr& first, const uint num_rows,
+		const uint8_t pattern, const uint min_ms, const uint max_ms, const uint levels,
+		const bool progress, ThroughputModel* model){
+
+	ThroughputModel local;
+	if(!model){
+		model = &local;
+		model->calibrate(be, first, pattern);
+	}
+
+	uint first_row = first.bank*NUM_ROWS + first.row;
+	uint end_row = first_row + num_rows;
+	if(end_row > NUM_DIMM_ROWS || end_row < first_row)
+		end_row = NUM_DIMM_ROWS;
+
+	std::vector<uint32_t> probe(levels < 2 ? 1 : levels);
+	for(uint k = 0; k < probe.size(); k++)
+		probe[k] = probe.size() == 1 ? max_ms :
+			round(min_ms*pow((double)max_ms/min_ms, (double)k/(probe.size() - 1)));
+
+	// indices of the longest passing (lo) and shortest failing (hi) probe
+	int top = probe.size();
+	std::vector<int> lo(end_row - first_row, -1), hi(end_row - first_row, top);
+
+	InstructionSequence* iseq = nullptr;
+	std::vector<char> failed;
+
+	for(uint pass = 0; ; pass++){
+		// rows that wait for the same probe form a batch
+		std::vector<std::vector<uint>> batches(probe.size());
+		bool any = false;
+
+		for(uint i = 0; i < lo.size(); i++){
+			if(hi[i] - lo[i] <= 1)
+				continue;
+
+			int k = hi[i] == top ? top - 1 : (lo[i] + hi[i])/2;
+			batches[k].push_back(first_row + i);
+			any = true;
+		}
+
+		if(!any)
+			break;
+
+		for(uint k = 0; k < probe.size(); k++){
+			std::vector<uint>& rows = batches[k];
+			if(progress && !rows.empty())
+				printf("Pass %u: %zu rows @ %u ms \n", pass, rows.size(), probe[k]);
+
+			for(uint g = 0, n = 0; g < rows.size(); g += n){
+				uint group_size = model->groupSize(probe[k]);
+				n = rows.size() - g < group_size ? rows.size() - g : group_size;
+				const uint* group = rows.data() + g;
+
+				failed.assign(n, 0);
+				uint cur = 0;
+				// compareRow reports the rows in the order they are read
+				ErrorSink mark = [&](const ReadError& e){
+					uint r = e.bank*NUM_ROWS + e.row;
+					while(cur < n && group[cur] != r)
+						cur++;
+					if(cur < n)
+						failed[cur] = 1;
+				};
+
+				testRetentionGroup(be, probe[k], group, n, pattern, mark, iseq, model);
+
+				for(uint i = 0; i < n; i++){
+					if(failed[i])
+						hi[group[i] - first_row] = k;
+					else
+						lo[group[i] - first_row] = k;
+				}
+			}
+		}
+	}
+
+	delete iseq;
+
+	std::vector<RowRetention> res(lo.size());
+	for(uint i = 0; i < lo.size(); i++)
+		res[i] = RowRetention(lo[i] < 0 ? 0 : probe[lo[i]], hi[i] == top ? NO_FAILURE : probe[hi[i]]);
+
+	return res;
+}
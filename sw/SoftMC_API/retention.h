@@ -0,0 +1,49 @@
+#ifndef RETENTION_H
+#define RETENTION_H
+
+#include <vector>
+#include "rowops.h"
+#include "throughput.h"
+#include "checkpoint.h"
+#include "roworder.h"
+#include "scheduler.h"
+
+#define NUM_DIMM_ROWS (NUM_ROWS*NUM_BANKS)
+
+//! Fills \e bursts (BURSTS_PER_ROW bytes) with the pattern of the linear row.
+typedef std::function<void(uint row, uint8_t* bursts)> RowPattern;
+
+void testRetention(Backend* be, const int retention, const DramAddr& first, const uint num_rows,
+		const uint8_t pattern, const ErrorSink& sink, const bool progress = false,
+		ThroughputModel* model = nullptr, Checkpoint* ckpt = nullptr);
+void testRetention(Backend* be, const int retention, const RowOrder& order,
+		const uint8_t pattern, const ErrorSink& sink, const bool progress = false,
+		ThroughputModel* model = nullptr, Checkpoint* ckpt = nullptr);
+void writeRowGroup(Backend* be, const uint* rows, const uint num_rows, const uint8_t pattern,
+		InstructionSequence*& iseq);
+void readRowGroup(Backend* be, const uint* rows, const uint num_rows, const uint8_t pattern,
+		const ErrorSink& sink, InstructionSequence*& iseq);
+void writeRowGroup(Backend* be, const uint* rows, const uint num_rows, const RowPattern& pattern,
+		InstructionSequence*& iseq);
+void readRowGroup(Backend* be, const uint* rows, const uint num_rows, const RowPattern& pattern,
+		const ErrorSink& sink, InstructionSequence*& iseq);
+void testRetentionGroup(Backend* be, const int retention, const uint* rows, const uint num_rows,
+		const uint8_t pattern, const ErrorSink& sink, InstructionSequence*& iseq,
+		ThroughputModel* model = nullptr, DeadlineScheduler* waits = nullptr);
+
+//! Retention time bounds of a row, as found by profileRetention.
+class RowRetention{
+
+	public:
+		uint32_t pass_ms; //longest probed retention time the row passed at, 0 if none
+		uint32_t fail_ms; //shortest probed retention time the row failed at, NO_FAILURE if none
+
+		RowRetention() : RowRetention(0, NO_FAILURE){}
+		RowRetention(uint32_t pass_ms, uint32_t fail_ms){ this->pass_ms = pass_ms; this->fail_ms = fail_ms; }
+};
+
+std::vector<RowRetention> profileRetention(Backend* be, const DramAddr& first, const uint num_rows,
+		const uint8_t pattern, const uint min_ms, const uint max_ms, const uint levels,
+		const bool progress = false, ThroughputModel* model = nullptr);
+
+#endif //RETENTION_H
@@ -0,0 +1,162 @@
+#include "rowmap.h"
+#include <stdio.h>
+#include <map>
+#include <algorithm>
+
+using namespace std;
+
+uint XorMapping::physical(uint row) const{
+	for(const XorRule& r : rules)
+		if((row & r.cond_mask) == r.cond_mask)
+			row ^= r.xor_mask;
+
+	return row;
+}
+
+TableMapping::TableMapping(){
+	table.resize(NUM_ROWS);
+	for(uint i = 0; i < NUM_ROWS; i++)
+		table[i] = i;
+}
+
+//! Reads "logical physical" pairs, one per line. Rows that are not listed
+//map to themselves.
+bool TableMapping::load(const char* path){
+	FILE* f = fopen(path, "r");
+	if(!f)
+		return false;
+
+	*this = TableMapping();
+
+	uint l, p;
+	bool ok = true;
+	while(ok && fscanf(f, "%u %u", &l, &p) == 2){
+		if(l >= NUM_ROWS || p >= NUM_ROWS)
+			ok = false;
+		else
+			table[l] = p;
+	}
+
+	ok = ok && feof(f);
+	fclose(f);
+	return ok;
+}
+
+//! Writes the rows that do not map to themselves in the format of load().
+bool TableMapping::save(const char* path) const{
+	FILE* f = fopen(path, "w");
+	if(!f)
+		return false;
+
+	for(uint i = 0; i < table.size(); i++)
+		if(table[i] != i)
+			fprintf(f, "%u %u\n", i, table[i]);
+
+	return fclose(f) == 0;
+}
+
+//! Learns the mapping from pairs of logical rows that were found to be
+//physical neighbours (e.g. an aggressor and the victim it disturbed).
+/*!
+  Scrambling is assumed to stay within aligned blocks of \e block_rows rows.
+ Where the pairs of a block link all of its rows into a single chain, the
+ rows are numbered along the chain, starting from the end that is adjacent
+ to the previous block (or from the lower logical row). Other blocks keep
+ the identity mapping.
+*/
+TableMapping TableMapping::learn(const vector<pair<uint, uint>>& adjacent, uint block_rows){
+	TableMapping m;
+	map<uint, vector<uint>> nbrs;
+
+	for(const auto& p : adjacent){
+		if(p.first >= NUM_ROWS || p.second >= NUM_ROWS || p.first == p.second)
+			continue;
+
+		vector<uint>& a = nbrs[p.first];
+		vector<uint>& b = nbrs[p.second];
+		if(find(a.begin(), a.end(), p.second) == a.end()){
+			a.push_back(p.second);
+			b.push_back(p.first);
+		}
+	}
+
+	for(uint base = 0; base + block_rows <= NUM_ROWS; base += block_rows){
+		// neighbours inside the block; a row of a chain has at most two
+		vector<vector<uint>> in(block_rows);
+		uint prev_link = NUM_ROWS;
+		bool valid = true;
+
+		for(uint r = base; r < base + block_rows && valid; r++){
+			auto it = nbrs.find(r);
+			if(it == nbrs.end())
+				continue;
+
+			for(uint n : it->second){
+				if(n >= base && n < base + block_rows)
+					in[r - base].push_back(n);
+				else if(base && m.table[n] == base - 1)
+					prev_link = r;
+			}
+			valid = in[r - base].size() <= 2;
+		}
+
+		vector<uint> ends;
+		for(uint i = 0; i < block_rows && valid; i++){
+			if(in[i].empty())
+				valid = false;
+			else if(in[i].size() == 1)
+				ends.push_back(base + i);
+		}
+
+		if(!valid || ends.size() != 2)
+			continue;
+
+		uint start = ends[1] == prev_link ? ends[1] : ends[0];
+		vector<uint> chain(1, start);
+		for(uint prev = NUM_ROWS, cur = start; chain.size() < block_rows;){
+			const vector<uint>& n = in[cur - base];
+			uint next = n[0] != prev ? n[0] : (n.size() > 1 ? n[1] : NUM_ROWS);
+			if(next == NUM_ROWS)
+				break;
+
+			prev = cur;
+			cur = next;
+			chain.push_back(cur);
+		}
+
+		if(chain.size() != block_rows)
+			continue;
+
+		for(uint i = 0; i < block_rows; i++)
+			m.table[chain[i]] = base + i;
+	}
+
+	return m;
+}
+
+RowMap::RowMap(){
+	set(IdentityMapping());
+}
+
+//! Caches the mapping in both directions.
+/*!
+  \return false, keeping the current mapping, if \e m is not a bijection.
+*/
+bool RowMap::set(const RowMapping& m){
+	vector<uint> p(NUM_ROWS), l(NUM_ROWS, NUM_ROWS);
+	bool id = true;
+
+	for(uint r = 0; r < NUM_ROWS; r++){
+		p[r] = m.physical(r);
+		if(p[r] >= NUM_ROWS || l[p[r]] != NUM_ROWS)
+			return false;
+
+		l[p[r]] = r;
+		id = id && p[r] == r;
+	}
+
+	phys.swap(p);
+	logi.swap(l);
+	is_identity = id;
+	return true;
+}
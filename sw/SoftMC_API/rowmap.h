@@ -0,0 +1,111 @@
+#ifndef ROWMAP_H
+#define ROWMAP_H
+
+#include <vector>
+#include <utility>
+#include "roworder.h"
+
+//! A logical-to-physical row address mapping inside the DRAM chips.
+/*!
+  physical() must be a bijection on [0, NUM_ROWS). The mapping is the same
+ in every bank.
+*/
+class RowMapping{
+
+	public:
+		virtual ~RowMapping(){}
+
+		virtual uint physical(uint row) const = 0;
+};
+
+class IdentityMapping : public RowMapping{
+
+	public:
+		uint physical(uint row) const { return row; }
+};
+
+//! Flips xor_mask in rows that have all bits of cond_mask set.
+class XorRule{
+
+	public:
+		uint cond_mask;
+		uint xor_mask;
+
+		XorRule(uint cond_mask, uint xor_mask){ this->cond_mask = cond_mask; this->xor_mask = xor_mask; }
+};
+
+//! Mapping made of XorRules, applied one after the other.
+/*!
+  E.g. XorRule(1 << 3, 0x6) inverts row bits 1 and 2 when bit 3 is set. The
+ rules must not flip their own condition bits, or the mapping is not
+ invertible.
+*/
+class XorMapping : public RowMapping{
+
+	public:
+		XorMapping(){}
+		XorMapping(const std::vector<XorRule>& rules){ this->rules = rules; }
+
+		uint physical(uint row) const;
+
+		std::vector<XorRule> rules;
+};
+
+//! Mapping given as a table of the physical row of every logical row.
+class TableMapping : public RowMapping{
+
+	public:
+		TableMapping();
+		TableMapping(const std::vector<uint>& table){ this->table = table; }
+
+		uint physical(uint row) const { return row < table.size() ? table[row] : row; }
+
+		bool load(const char* path);
+		bool save(const char* path) const;
+
+		static TableMapping learn(const std::vector<std::pair<uint, uint>>& adjacent, uint block_rows = 16);
+
+		std::vector<uint> table;
+};
+
+//! Cached lookup of a RowMapping in both directions.
+class RowMap{
+
+	public:
+		RowMap();
+
+		bool set(const RowMapping& m);
+
+		uint toPhysical(uint row) const { return phys[row]; }
+		uint toLogical(uint row) const { return logi[row]; }
+
+		bool identity() const { return is_identity; }
+
+	private:
+		std::vector<uint> phys; //logical -> physical
+		std::vector<uint> logi; //physical -> logical
+		bool is_identity;
+};
+
+//! Visits the physical rows given by another order.
+/*!
+  \e physical yields physical rows; at() returns the logical rows that the
+ engines (and genACT) need, translated with one table lookup per row.
+*/
+class PhysicalOrder : public RowOrder{
+
+	public:
+		PhysicalOrder(const RowOrder& physical, const RowMap& map){ this->order = &physical; this->map = &map; }
+
+		uint size() const { return order->size(); }
+		uint at(uint i) const {
+			uint r = order->at(i);
+			return (r/NUM_ROWS)*NUM_ROWS + map->toLogical(r%NUM_ROWS);
+		}
+
+	private:
+		const RowOrder* order;
+		const RowMap* map;
+};
+
+#endif //ROWMAP_H
@@ -0,0 +1,193 @@
+#include "rowops.h"
+#include <stdio.h>
+#include <string.h>
+
+//Note that capacity of the instruction buffer is 8192 instructions
+//! Writes the given byte pattern to the entire row.
+/*!
+  \param \e be is the board to use.
+  \param \e row is the row number.
+  \param \e bank is the bank number.
+  \param \e pattern is the byte that will be written to every column.
+  \param \e iseq is reused to avoid a dynamic allocation on each call. It is
+ allocated if nullptr.
+*/
+void writeRow(Backend* be, uint row, uint bank, uint8_t pattern, InstructionSequence*& iseq){
+	uint8_t bursts[BURSTS_PER_ROW];
+	memset(bursts, pattern, BURSTS_PER_ROW);
+
+	writeRow(be, row, bank, bursts, iseq);
+}
+
+//! Writes a byte pattern per burst to the row: every column of burst i (columns
+//8i to 8i + 7) gets \e bursts[i], as genWR repeats its 8-bit pattern.
+void writeRow(Backend* be, uint row, uint bank, const uint8_t* bursts, InstructionSequence*& iseq){
+
+	if(iseq == nullptr)
+		iseq = new InstructionSequence();
+	else
+		iseq->size = 0;//reuse the provided InstructionSequence to avoid dynamic allocation on each call
+
+	//Precharge target bank (just in case if its left activated)
+	iseq->insert(genPRE(bank, PRE_TYPE::SINGLE));
+
+	//Wait for tRP
+	iseq->insert(genWAIT(5));//2.5ns have already been passed as we issue in next cycle. So, 5 means 6 cycles latency, 15 ns
+
+	//Activate target row
+	iseq->insert(genACT(bank, row));
+
+	//Wait for tRCD
+	iseq->insert(genWAIT(5));
+
+	//Write to the entire row
+	for(int i = 0; i < NUM_COLS; i+=8){ //we use 8x burst mode
+		iseq->insert(genWR(bank, i, bursts[i/8]));
+
+		//We need to wait for tCL and 4 cycles burst (double data-rate)
+		iseq->insert(genWAIT(6 + 4));
+	}
+
+	//Wait some more in any case
+	iseq->insert(genWAIT(3));
+
+	//Precharge target bank
+	iseq->insert(genPRE(bank, PRE_TYPE::SINGLE));
+
+	//Wait for tRP
+	iseq->insert(genWAIT(5));//we have already 2.5ns passed as we issue in next cycle. So, 5 means 6 cycles latency, 15 ns
+
+	//START Transaction
+	iseq->insert(genEND());
+
+	iseq->execute(be);
+}
+
+//! Issues the instructions that read the entire row. The data is received
+//with compareRow.
+void readRow(Backend* be, uint row, uint bank, InstructionSequence*& iseq){
+
+	if(iseq == nullptr)
+		iseq = new InstructionSequence();
+	else
+		iseq->size = 0;//reuse the provided InstructionSequence to avoid dynamic allocation for each call
+
+	//Precharge target bank (just in case if its left activated)
+	iseq->insert(genPRE(bank, PRE_TYPE::SINGLE));
+
+	//Wait for tRP
+	iseq->insert(genWAIT(5));//2.5ns have already been passed as we issue in next cycle. So, 5 means 6 cycles latency, 15 ns
+
+	//Activate target row
+	iseq->insert(genACT(bank, row));
+
+	//Wait for tRCD
+	iseq->insert(genWAIT(5));
+
+	//Read the entire row
+	for(int i = 0; i < NUM_COLS; i+=8){ //we use 8x burst mode
+		iseq->insert(genRD(bank, i));
+
+		//We need to wait for tCL and 4 cycles burst (double data-rate)
+		iseq->insert(genWAIT(6 + 4));
+	}
+
+	//Wait some more in any case
+	iseq->insert(genWAIT(3));
+
+	//Precharge target bank
+	iseq->insert(genPRE(bank, PRE_TYPE::SINGLE)); //pre 1 -> precharge all, pre 0 precharge bank
+
+	//Wait for tRP
+	iseq->insert(genWAIT(5));//we have already 2.5ns passed as we issue in next cycle. So, 5 means 6 cycles latency, 15 ns
+
+	//START Transaction
+	iseq->insert(genEND());
+
+	iseq->execute(be);
+}
+
+//! Receives the data of a row read with readRow and compares it with the
+//pattern. Every mismatching byte is reported to the sink.
+/*!
+  A burst is compared one column (the 8 byte lanes of the bus) at a time as
+ a 64-bit word, only mismatching columns are compared byte by byte.
+*/
+void compareRow(Backend* be, uint row, uint bank, uint8_t pattern, const ErrorSink& sink){
+	uint8_t bursts[BURSTS_PER_ROW];
+	memset(bursts, pattern, BURSTS_PER_ROW);
+
+	compareRow(be, row, bank, bursts, sink);
+}
+
+//! Compares the row with a byte pattern per burst, written with writeRow.
+void compareRow(Backend* be, uint row, uint bank, const uint8_t* bursts, const ErrorSink& sink){
+
+	//Receive the data
+	uint rbuf[BURST_WORDS];
+	for(int i = 0; i < NUM_COLS; i+=8){ //we receive a single burst at two times (32 bytes each)
+		be->recv(be->chnls.rdback, (void*)rbuf, BURST_WORDS);
+
+		uint8_t pattern = bursts[i/8];
+		uint64_t expected = 0x0101010101010101ULL*pattern;
+
+		//compare with the pattern
+		uint8_t* rbuf8 = (uint8_t *) rbuf;
+
+		for(int c = 0; c < BURST_BYTES; c += 8){
+			uint64_t word;
+			memcpy(&word, rbuf8 + c, sizeof(word));
+			if(word == expected)
+				continue;
+
+			for(int j = c; j < c + 8; j++){
+				if(rbuf8[j] != pattern)
+					sink(ReadError(bank, row, i + j/8, j%8, rbuf8[j], pattern));
+			}
+		}
+	}
+}
+
+void readAndCompareRow(Backend* be, uint row, uint bank, uint8_t pattern, InstructionSequence*& iseq, const ErrorSink& sink){
+	readRow(be, row, bank, iseq);
+	compareRow(be, row, bank, pattern, sink);
+}
+
+void turnBus(Backend* be, BUSDIR b, InstructionSequence*& iseq){
+
+	if(iseq == nullptr)
+		iseq = new InstructionSequence();
+	else
+		iseq->size = 0;//reuse the provided InstructionSequence to avoid dynamic allocation for each call
+
+	iseq->insert(genBUSDIR(b));
+
+	//WAIT
+	iseq->insert(genWAIT(5));
+
+	//START Transaction
+	iseq->insert(genEND());
+
+	iseq->execute(be);
+}
+
+// provide trefi = 0 to disable auto-refresh
+// auto-refresh is disabled by default (disabled after FPGA boots, disables on pushing reset button)
+void setRefreshConfig(Backend* be, uint trefi, uint trfc){
+	InstructionSequence* iseq = new InstructionSequence;
+
+	iseq->insert(genREF_CONFIG(trfc, REGISTER::TRFC));
+	iseq->insert(genREF_CONFIG(trefi, REGISTER::TREFI));
+
+	//START Transaction
+	iseq->insert(genEND());
+
+	iseq->execute(be);
+
+	delete iseq;
+}
+
+//! Prints the error in the text format of the retention test.
+void printError(const ReadError& err){
+	fprintf(stderr, "Error at Col: %u, Row: %u, Bank: %u, DATA: %x \n", err.col, err.row, err.bank, err.data);
+}
@@ -0,0 +1,58 @@
+#ifndef ROWOPS_H
+#define ROWOPS_H
+
+#include <functional>
+#include "softmc.h"
+
+// Each read burst (BL8 on the 64-bit bus) is sent back as 16 words
+#define BURST_WORDS 16
+#define BURST_BYTES 64
+#define BURSTS_PER_ROW (NUM_COLS/8)
+
+// cycles between ACTs to different banks (tRRD) and between bursts (tCCD,
+//BL8 takes 4 cycles of the bus)
+#define TRRD_CYCLES 4
+#define TCCD_CYCLES 4
+
+// the refresh engine counts tREFI in ticks of its 200 ns prescaler and
+//refreshes every row once per 8192 REFs (a refresh window)
+#define REF_TICK_NS 200
+#define REFS_PER_WINDOW 8192
+#define SPEC_TREFI_TICKS (7800/REF_TICK_NS) //7.8us
+#define SPEC_TRFC_CYCLES 104 //4Gb device
+
+// retention time of a row or cell that has not been seen failing
+#define NO_FAILURE 0xFFFFFFFF
+
+//! A byte read back from the DRAM that does not match the written pattern.
+class ReadError{
+
+	public:
+		uint bank;
+		uint row;
+		uint col;
+		uint lane; //byte lane (0-7) of the 64-bit data bus
+		uint8_t data;
+		uint8_t expected;
+
+		ReadError() : ReadError(0, 0, 0, 0, 0, 0){}
+		ReadError(uint bank, uint row, uint col, uint lane, uint8_t data, uint8_t expected){
+			this->bank = bank; this->row = row; this->col = col; this->lane = lane;
+			this->data = data; this->expected = expected;
+		}
+};
+
+typedef std::function<void(const ReadError&)> ErrorSink;
+
+void writeRow(Backend* be, uint row, uint bank, uint8_t pattern, InstructionSequence*& iseq);
+void writeRow(Backend* be, uint row, uint bank, const uint8_t* bursts, InstructionSequence*& iseq);
+void readRow(Backend* be, uint row, uint bank, InstructionSequence*& iseq);
+void compareRow(Backend* be, uint row, uint bank, uint8_t pattern, const ErrorSink& sink);
+void compareRow(Backend* be, uint row, uint bank, const uint8_t* bursts, const ErrorSink& sink);
+void readAndCompareRow(Backend* be, uint row, uint bank, uint8_t pattern, InstructionSequence*& iseq, const ErrorSink& sink);
+void turnBus(Backend* be, BUSDIR b, InstructionSequence*& iseq);
+void setRefreshConfig(Backend* be, uint trefi, uint trfc);
+
+void printError(const ReadError& err);
+
+#endif //ROWOPS_H
@@ -0,0 +1,102 @@
+#include "roworder.h"
+#include "splitmix.h"
+
+RangeOrder::RangeOrder(const DramAddr& first, uint num_rows){
+	first_row = first.bank*NUM_ROWS + first.row;
+
+	uint total = NUM_ROWS*NUM_BANKS;
+	this->num_rows = first_row >= total ? 0 : (num_rows < total - first_row ? num_rows : total - first_row);
+}
+
+BankMajorOrder::BankMajorOrder(const RowRegion& region){
+	this->region = region;
+}
+
+uint BankMajorOrder::at(uint i) const{
+	uint rows = region.rows();
+	return (region.bank_begin + i/rows)*NUM_ROWS + region.row_begin + i%rows;
+}
+
+BankInterleavedOrder::BankInterleavedOrder(const RowRegion& region){
+	this->region = region;
+}
+
+uint BankInterleavedOrder::at(uint i) const{
+	uint banks = region.banks();
+	return (region.bank_begin + i%banks)*NUM_ROWS + region.row_begin + i/banks;
+}
+
+RowStrideOrder::RowStrideOrder(const RowRegion& region, uint stride){
+	this->region = region;
+	this->stride = stride ? stride : 1;
+}
+
+uint RowStrideOrder::at(uint i) const{
+	uint rows = region.rows();
+	uint bank = region.bank_begin + i/rows;
+	uint j = i%rows;
+
+	// rows are visited by residue class modulo the stride; the first
+	//rows%stride classes have one more row than the others
+	uint s = stride < rows ? stride : rows;
+	uint q = rows/s;
+	uint big = rows%s;
+	uint c, k;
+
+	if(j < big*(q + 1)){
+		c = j/(q + 1);
+		k = j%(q + 1);
+	}
+	else{
+		j -= big*(q + 1);
+		c = big + j/q;
+		k = j%q;
+	}
+
+	return bank*NUM_ROWS + region.row_begin + c + k*s;
+}
+
+RandomOrder::RandomOrder(const RowRegion& region, uint64_t seed) : base(region){
+	this->seed = seed;
+
+	half_bits = 1;
+	while((1ULL << (2*half_bits)) < region.size())
+		half_bits++;
+
+	uint64_t x = seed;
+	for(uint r = 0; r < 4; r++)
+		keys[r] = splitmix64(x);
+}
+
+uint RandomOrder::permute(uint i) const{
+	uint32_t mask = (1u << half_bits) - 1;
+	uint n = size();
+
+	// the Feistel network permutes [0, 4^half_bits), apply it again until
+	//the index lands inside the region
+	do{
+		uint32_t l = i >> half_bits, r = i & mask;
+		for(uint k = 0; k < 4; k++){
+			uint32_t f = (r*0x9E3779B1u ^ keys[k]) * 0x85EBCA6Bu;
+			f ^= f >> 15;
+			uint32_t t = l ^ (f & mask);
+			l = r;
+			r = t;
+		}
+		i = (l << half_bits) | r;
+	} while(i >= n);
+
+	return i;
+}
+
+SliceOrder::SliceOrder(const RowOrder& base, uint begin, uint end){
+	this->base = &base;
+	this->end = end < base.size() ? end : base.size();
+	this->begin = begin < this->end ? begin : this->end;
+}
+
+ListOrder::ListOrder(const std::vector<DramAddr>& addrs){
+	rows.reserve(addrs.size());
+	for(const DramAddr& a : addrs)
+		rows.push_back(a.bank*NUM_ROWS + a.row);
+}
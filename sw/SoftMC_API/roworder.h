@@ -0,0 +1,189 @@
+#ifndef ROWORDER_H
+#define ROWORDER_H
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+#include "softmc.h"
+
+// rows of a subarray (sharing local sense amplifiers) in most DDR3 chips
+#define SUBARRAY_ROWS 512
+
+//! A rectangle of rows: banks [bank_begin, bank_end) x rows [row_begin, row_end).
+class RowRegion{
+
+	public:
+		uint bank_begin, bank_end;
+		uint row_begin, row_end;
+
+		RowRegion() : RowRegion(0, NUM_BANKS, 0, NUM_ROWS){}
+		RowRegion(uint bank_begin, uint bank_end, uint row_begin, uint row_end){
+			this->bank_begin = bank_begin; this->bank_end = bank_end;
+			this->row_begin = row_begin; this->row_end = row_end;
+		}
+
+		uint banks() const { return bank_end - bank_begin; }
+		uint rows() const { return row_end - row_begin; }
+		uint size() const { return banks()*rows(); }
+};
+
+class RowOrder;
+
+//! Forward iterator over the DramAddrs of a RowOrder.
+class RowIterator{
+
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef DramAddr value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const DramAddr* pointer;
+		typedef DramAddr reference;
+
+		RowIterator(const RowOrder* order, uint i){ this->order = order; this->i = i; }
+
+		DramAddr operator*() const;
+		RowIterator& operator++(){ i++; return *this; }
+		bool operator!=(const RowIterator& o) const { return i != o.i; }
+		bool operator==(const RowIterator& o) const { return i == o.i; }
+
+		uint index() const { return i; }
+
+	private:
+		const RowOrder* order;
+		uint i;
+};
+
+//! The order in which a test visits rows.
+/*!
+  at(i) maps the visit index i in [0, size()) to a linear row
+ (bank*NUM_ROWS + row); every row of the order is visited exactly once.
+ Orders compute the row on the fly, so iterating allocates nothing.
+*/
+class RowOrder{
+
+	public:
+		virtual ~RowOrder(){}
+
+		virtual uint size() const = 0;
+		virtual uint at(uint i) const = 0;
+
+		DramAddr addr(uint i) const { uint r = at(i); return DramAddr(r%NUM_ROWS, r/NUM_ROWS); }
+
+		RowIterator begin() const { return RowIterator(this, 0); }
+		RowIterator end() const { return RowIterator(this, size()); }
+};
+
+inline DramAddr RowIterator::operator*() const { return order->addr(i); }
+
+//! num_rows consecutive linear rows from \e first, capped at the end of the DIMM.
+class RangeOrder : public RowOrder{
+
+	public:
+		RangeOrder(const DramAddr& first, uint num_rows);
+
+		uint size() const { return num_rows; }
+		uint at(uint i) const { return first_row + i; }
+
+		uint first_row;
+		uint num_rows;
+};
+
+//! Row after row, bank after bank (the order of the original retention test).
+class BankMajorOrder : public RowOrder{
+
+	public:
+		BankMajorOrder(const RowRegion& region = RowRegion());
+
+		uint size() const { return region.size(); }
+		uint at(uint i) const;
+
+		RowRegion region;
+};
+
+//! Visits the same row of every bank before moving to the next row, which
+//lets consecutive accesses use different banks.
+class BankInterleavedOrder : public RowOrder{
+
+	public:
+		BankInterleavedOrder(const RowRegion& region = RowRegion());
+
+		uint size() const { return region.size(); }
+		uint at(uint i) const;
+
+		RowRegion region;
+};
+
+//! Visits the rows of each bank \e stride apart: row_begin, row_begin + stride,
+//..., then row_begin + 1, row_begin + 1 + stride, ... Banks follow each other.
+class RowStrideOrder : public RowOrder{
+
+	public:
+		RowStrideOrder(const RowRegion& region, uint stride);
+
+		uint size() const { return region.size(); }
+		uint at(uint i) const;
+
+		RowRegion region;
+		uint stride;
+};
+
+//! Visits one row of every subarray in turn, so that consecutive rows are
+//never physical neighbours that share sense amplifiers.
+class SubarrayOrder : public RowStrideOrder{
+
+	public:
+		SubarrayOrder(const RowRegion& region = RowRegion(), uint subarray_rows = SUBARRAY_ROWS)
+			: RowStrideOrder(region, subarray_rows){}
+};
+
+//! A pseudo-random permutation of the region, fixed by the seed.
+/*!
+  The permutation is a 4-round Feistel network over the next power of two
+ (4^k) above the region size, cycle-walking the indices that fall outside.
+*/
+class RandomOrder : public RowOrder{
+
+	public:
+		RandomOrder(const RowRegion& region, uint64_t seed);
+
+		uint size() const { return base.size(); }
+		uint at(uint i) const { return base.at(permute(i)); }
+
+		uint64_t seed;
+
+	private:
+		uint permute(uint i) const;
+
+		BankMajorOrder base;
+		uint half_bits;
+		uint32_t keys[4];
+};
+
+//! Visits [begin, end) of another order, e.g. to resume or to split it.
+class SliceOrder : public RowOrder{
+
+	public:
+		SliceOrder(const RowOrder& base, uint begin, uint end);
+
+		uint size() const { return end - begin; }
+		uint at(uint i) const { return base->at(begin + i); }
+
+	private:
+		const RowOrder* base;
+		uint begin, end;
+};
+
+//! Visits a list of rows in the given order, e.g. the weak rows found by an
+//earlier run.
+class ListOrder : public RowOrder{
+
+	public:
+		ListOrder(const std::vector<DramAddr>& addrs);
+
+		uint size() const { return rows.size(); }
+		uint at(uint i) const { return rows[i]; }
+
+		std::vector<uint> rows; //linear
+};
+
+#endif //ROWORDER_H
@@ -0,0 +1,346 @@
+#include "scan.h"
+#include "scheduler.h"
+#include <string.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+#define ROW_BYTES (NUM_COLS*8)
+
+// rows received into one huge page
+#define SCAN_CHUNK_ROWS (HUGE_PAGE_SIZE/ROW_BYTES)
+
+//! Rows [first, first + rows) of the plan, received into data.
+class ScanChunk{
+
+	public:
+		uint8_t* data;
+		uint first;
+		uint rows;
+
+		ScanChunk(uint8_t* data, uint first, uint rows){ this->data = data; this->first = first; this->rows = rows; }
+};
+
+//! Threads that check the received chunks against the pattern.
+/*!
+  Chunks are received into a fixed set of huge-page buffers. A buffer
+ returns to the free list once its chunk has been verified, so a slow
+ verifier holds the read back up (see acquire).
+*/
+class VerifierPool{
+
+	public:
+		VerifierPool(const StreamPlan& plan, uint8_t pattern, const ErrorSink& sink, uint threads);
+		~VerifierPool();
+
+		bool good() const { return !buffers.empty(); }
+
+		uint8_t* acquire();
+		void release(uint8_t* b);
+		void submit(const ScanChunk& c);
+		void finish(ScanStats& st);
+
+	private:
+		void work();
+		void verify(const ScanChunk& c);
+
+		const StreamPlan& plan;
+		uint8_t pattern;
+		const ErrorSink& sink;
+
+		mutex lock;
+		condition_variable work_cv, free_cv;
+		deque<ScanChunk> queue;
+		vector<uint8_t*> buffers, free;
+		vector<thread> threads;
+		bool done;
+
+		mutex sink_lock;
+		uint64_t errors, hash, verify_ns, stall_ns;
+};
+
+VerifierPool::VerifierPool(const StreamPlan& plan, uint8_t pattern, const ErrorSink& sink, uint threads)
+		: plan(plan), sink(sink){
+
+	this->pattern = pattern;
+	done = false;
+	errors = 0; hash = 0; verify_ns = 0; stall_ns = 0;
+
+	// two spare buffers keep the read back going while every thread verifies,
+	// under memory pressure the scan makes do with the buffers it got
+	for(uint i = 0; i < threads + 2; i++){
+		uint8_t* b = (uint8_t*)allocHugeBuffer(HUGE_PAGE_SIZE);
+		if(b == nullptr)
+			break;
+
+		buffers.push_back(b);
+		free.push_back(b);
+	}
+
+	for(uint i = 0; i < threads; i++)
+		this->threads.push_back(thread(&VerifierPool::work, this));
+}
+
+VerifierPool::~VerifierPool(){
+	{
+		lock_guard<mutex> l(lock);
+		done = true;
+	}
+	work_cv.notify_all();
+
+	for(thread& t : threads)
+		t.join();
+
+	for(uint8_t* b : buffers)
+		freeHugeBuffer(b, HUGE_PAGE_SIZE);
+}
+
+//! Returns a free buffer, waiting for one if all of them hold chunks.
+uint8_t* VerifierPool::acquire(){
+	unique_lock<mutex> l(lock);
+	if(free.empty()){
+		uint64_t start = DeadlineScheduler::now();
+		free_cv.wait(l, [this]{ return !free.empty(); });
+		stall_ns += DeadlineScheduler::now() - start;
+	}
+
+	uint8_t* b = free.back();
+	free.pop_back();
+	return b;
+}
+
+//! Returns a buffer that was not filled.
+void VerifierPool::release(uint8_t* b){
+	{
+		lock_guard<mutex> l(lock);
+		free.push_back(b);
+	}
+	free_cv.notify_all();
+}
+
+void VerifierPool::submit(const ScanChunk& c){
+	{
+		lock_guard<mutex> l(lock);
+		queue.push_back(c);
+	}
+	work_cv.notify_one();
+}
+
+//! Waits until every submitted chunk has been verified and adds the results
+//to \e st.
+void VerifierPool::finish(ScanStats& st){
+	unique_lock<mutex> l(lock);
+	free_cv.wait(l, [this]{ return free.size() == buffers.size(); });
+
+	st.errors += errors;
+	st.hash += hash;
+	st.verify_ms += verify_ns/1e6;
+	st.stall_ms += stall_ns/1e6;
+}
+
+void VerifierPool::work(){
+	while(true){
+		unique_lock<mutex> l(lock);
+		work_cv.wait(l, [this]{ return done || !queue.empty(); });
+		if(queue.empty())
+			return;
+
+		ScanChunk c = queue.front();
+		queue.pop_front();
+		l.unlock();
+
+		uint64_t start = DeadlineScheduler::now();
+		verify(c);
+
+		l.lock();
+		verify_ns += DeadlineScheduler::now() - start;
+		free.push_back(c.data);
+		l.unlock();
+		free_cv.notify_all();
+	}
+}
+
+//! Compares the rows of the chunk with the pattern a column (64-bit word) at
+//a time and hashes them.
+void VerifierPool::verify(const ScanChunk& c){
+	uint64_t expected = 0x0101010101010101ULL*pattern;
+	uint64_t errs = 0, sum = 0;
+
+	for(uint i = 0; i < c.rows; i++){
+		uint r = plan.rows[c.first + i];
+		const uint8_t* data = c.data + (size_t)i*ROW_BYTES;
+
+		uint64_t h = 0xcbf29ce484222325ULL ^ r;
+		for(uint w = 0; w < ROW_BYTES; w += 8){
+			uint64_t word;
+			memcpy(&word, data + w, sizeof(word));
+			h = (h ^ word)*0x100000001b3ULL;
+
+			if(word == expected)
+				continue;
+
+			for(uint j = w; j < w + 8; j++){
+				if(data[j] != pattern){
+					errs++;
+					lock_guard<mutex> l(sink_lock);
+					sink(ReadError(r/NUM_ROWS, r%NUM_ROWS, j/8, j%8, data[j], pattern));
+				}
+			}
+		}
+
+		sum += h ^ (h >> 29);
+	}
+
+	lock_guard<mutex> l(lock);
+	errors += errs;
+	hash += sum;
+}
+
+//! Receives the read back data of the scan into chunks.
+class ScanReceiver{
+
+	public:
+		ScanReceiver(Backend* be, VerifierPool& pool) : pool(pool){
+			this->be = be; buf = nullptr; first = 0; filled = 0; lost = 0;
+		}
+
+		void receive(uint rows);
+		void flush();
+
+	private:
+		Backend* be;
+		VerifierPool& pool;
+		uint8_t* buf;
+		uint first; //first row of the current chunk
+		uint filled; //rows received into the current chunk
+
+	public:
+		uint64_t lost; //rows not received
+};
+
+//! Receives the next \e rows rows, submitting every full chunk.
+/*!
+  Once a receive times out or fails, the data that follows can not be told
+ apart from the rows it belongs to, so the rows not received completely and
+ every row after them are counted as lost instead of being verified.
+*/
+void ScanReceiver::receive(uint rows){
+	if(lost){
+		lost += rows;
+		return;
+	}
+
+	while(rows){
+		if(buf == nullptr)
+			buf = pool.acquire();
+
+		uint n = min(rows, (uint)SCAN_CHUNK_ROWS - filled);
+		uint* words = (uint*)(buf + (size_t)filled*ROW_BYTES);
+		int want = n*ROW_BYTES/sizeof(uint);
+		int got = 0;
+		while(got < want){
+			int r = be->recv(be->chnls.rdback, words + got, want - got);
+			if(r <= 0)
+				break;
+			got += r;
+		}
+
+		if(got < want){
+			uint whole = got*sizeof(uint)/ROW_BYTES;
+			filled += whole;
+			lost = rows - whole;
+			flush();
+			return;
+		}
+
+		filled += n;
+		rows -= n;
+
+		if(filled == SCAN_CHUNK_ROWS)
+			flush();
+	}
+}
+
+//! Submits the current chunk, even if it is not full.
+void ScanReceiver::flush(){
+	if(filled)
+		pool.submit(ScanChunk(buf, first, filled));
+	else if(buf)
+		pool.release(buf);
+
+	first += filled;
+	filled = 0;
+	buf = nullptr;
+}
+
+BOTTLENECK ScanStats::bottleneck() const{
+	if(stall_ms > 0.1*ms || verify_ms > 0.9*ms*threads)
+		return BOTTLENECK::HOST;
+
+	if(dram_ms > 0.9*ms)
+		return BOTTLENECK::DRAM;
+
+	return BOTTLENECK::PCIE;
+}
+
+//! Reads every row of the order back to back across banks and checks it
+//against the pattern.
+/*!
+  The rows are read one row of every bank per group (see StreamPlan) with
+ back to back bursts. The read back data is received in 2 MiB chunks into
+ huge-page buffers, on a separate thread if the board has a separate read
+ back channel, and verified by a pool of threads.
+  If not even one buffer can be allocated, no row is read and every row is
+ counted as lost.
+  \param \e sink receives every mismatching byte, from one thread at a time.
+  \return The rows read, the rows lost to a failed receive or allocation, the errors, a hash of the data and the time spent
+ by the DRAM, the verifiers and waiting for buffers, which tell where the
+ bottleneck is.
+*/
+ScanStats scanRows(Backend* be, const RowOrder& order, const uint8_t pattern, const ErrorSink& sink,
+		const uint threads){
+
+	StreamPlan plan(order);
+	InstructionSequence* iseq = nullptr;
+	ScanStats st;
+	st.rows = plan.rows.size();
+	st.threads = max(threads, 1u);
+
+	uint64_t start = DeadlineScheduler::now();
+	turnBus(be, BUSDIR::READ, iseq);
+
+	StreamStats ss;
+	{
+		VerifierPool pool(plan, pattern, sink, st.threads);
+		ScanReceiver receiver(be, pool);
+
+		if(!pool.good())
+			receiver.lost = st.rows;
+		else if(be->chnls.instr != be->chnls.rdback){
+			thread t([&](){
+				receiver.receive(plan.rows.size());
+				receiver.flush();
+			});
+
+			ss = streamRows(be, plan, false, 0);
+			t.join();
+		}
+		else{
+			ss = streamRows(be, plan, false, 0, [&receiver](uint rows){ receiver.receive(rows); });
+			receiver.flush();
+		}
+
+		pool.finish(st);
+		st.lost = receiver.lost;
+	}
+
+	st.ms = (DeadlineScheduler::now() - start)/1e6;
+	st.dram_ms = ss.cycles*CYCLE_NS/1e6;
+
+	delete iseq;
+	return st;
+}
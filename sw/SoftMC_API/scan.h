@@ -0,0 +1,40 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include "stream.h"
+
+// verifier threads of a scan
+#define SCAN_THREADS 4
+
+enum class BOTTLENECK {
+	DRAM = 0, //the sequences keep the DRAM busy
+	PCIE = 1, //read back data arrives slower than the DRAM sends it
+	HOST = 2 //the verifiers do not keep up with the read back data
+};
+
+//! Outcome of a read scan.
+class ScanStats{
+
+	public:
+		uint64_t rows;
+		uint64_t lost; //rows whose read back was not received or had no buffer, so they were not verified
+		uint64_t errors; //mismatching bytes
+		uint64_t hash; //of the data read back, independent of the order the rows were read in
+		uint threads; //verifier threads
+		double ms; //until the last row was verified
+		double dram_ms; //the DRAM needs to run the sequences
+		double verify_ms; //verifier threads were busy, summed
+		double stall_ms; //read back waited for a free buffer
+
+		ScanStats(){ rows = 0; lost = 0; errors = 0; hash = 0; threads = 0; ms = 0; dram_ms = 0; verify_ms = 0; stall_ms = 0; }
+
+		uint64_t bytes() const { return (rows - lost)*NUM_COLS*8; }
+		double gbps() const { return ms > 0 ? bytes()/ms/1e6 : 0; }
+
+		BOTTLENECK bottleneck() const;
+};
+
+ScanStats scanRows(Backend* be, const RowOrder& order, const uint8_t pattern, const ErrorSink& sink,
+		const uint threads = SCAN_THREADS);
+
+#endif //SCAN_H
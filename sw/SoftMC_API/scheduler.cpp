@@ -0,0 +1,59 @@
+#include "scheduler.h"
+#include <time.h>
+#include <errno.h>
+
+using namespace std;
+
+#define NS_PER_SEC 1000000000ULL
+
+void WakeupStats::add(int64_t late_ns){
+	wakeups++;
+	total_late_ns += late_ns;
+	if(late_ns > max_late_ns)
+		max_late_ns = late_ns;
+}
+
+static struct timespec toTimespec(uint64_t ns){
+	struct timespec ts;
+	ts.tv_sec = ns / NS_PER_SEC;
+	ts.tv_nsec = ns % NS_PER_SEC;
+	return ts;
+}
+
+DeadlineScheduler::DeadlineScheduler(){
+	spin_ns = SCHED_SPIN_NS;
+}
+
+uint64_t DeadlineScheduler::now(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*NS_PER_SEC + ts.tv_nsec;
+}
+
+int64_t DeadlineScheduler::spinUntil(uint64_t deadline){
+	uint64_t t;
+	while((t = now()) < deadline)
+		;
+
+	return t - deadline;
+}
+
+//! Blocks until the deadline and returns how late (in ns) the wake-up was.
+int64_t DeadlineScheduler::waitUntil(uint64_t deadline){
+	if(deadline > now() + spin_ns){
+		struct timespec ts = toTimespec(deadline - spin_ns);
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+			;
+	}
+
+	int64_t late = spinUntil(deadline);
+
+	lock_guard<mutex> l(lock);
+	wstats.add(late);
+	return late;
+}
+
+WakeupStats DeadlineScheduler::stats(){
+	lock_guard<mutex> l(lock);
+	return wstats;
+}
@@ -0,0 +1,51 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <mutex>
+
+// the last part of a wait is spent spinning, as sleeps overshoot by tens of us
+#define SCHED_SPIN_NS 200000
+
+//! How far the wake-ups of a DeadlineScheduler were from their deadlines.
+class WakeupStats{
+
+	public:
+		uint64_t wakeups;
+		int64_t max_late_ns;
+		int64_t total_late_ns;
+
+		WakeupStats(){ wakeups = 0; max_late_ns = total_late_ns = 0; }
+
+		void add(int64_t late_ns);
+		double meanLateNs() const { return wakeups ? (double)total_late_ns/wakeups : 0.0; }
+};
+
+//! Waits for CLOCK_MONOTONIC deadlines (in ns) without burning a core.
+/*!
+  waitUntil() blocks the calling thread with clock_nanosleep and spins for
+ the last spin_ns to wake up on time. The tests keep their in-flight
+ deadlines ordered and wait for the earliest one, so one thread serves any
+ number of them. stats() reports how late the wake-ups were.
+*/
+class DeadlineScheduler{
+
+	public:
+		DeadlineScheduler();
+
+		static uint64_t now();
+
+		int64_t waitUntil(uint64_t deadline);
+
+		WakeupStats stats();
+
+		int64_t spin_ns;
+
+	private:
+		int64_t spinUntil(uint64_t deadline);
+
+		std::mutex lock;
+		WakeupStats wstats;
+};
+
+#endif //SCHEDULER_H
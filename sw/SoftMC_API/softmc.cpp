@@ -2,6 +2,7 @@
 #include <fstream>
 #include <iostream>
 #include <cassert>
+#include <sys/mman.h>
 
 using namespace std;
 
@@ -33,8 +34,109 @@ void InstructionSequence::insert(const Instruction c){
 	instrs[size++] = c;
 }
 
-void InstructionSequence::execute(fpga_t* fpga){
-	fpga_send(fpga, 0, (void*)instrs, INSTR_SIZE*size, 0, 1, 0);
+void InstructionSequence::execute(fpga_t* fpga, int chnl){
+	fpga_send(fpga, chnl, (void*)instrs, INSTR_SIZE*size, 0, 1, 0);
+}
+
+void InstructionSequence::execute(Backend* be){
+	be->send(be->chnls.instr, (void*)instrs, INSTR_SIZE*size);
+}
+
+//! Returns the channel layout of the board with the given id.
+/*!
+  \param \e info is the list populated by fpga_list.
+  \param \e fid is the id of the board.
+  \return Separate instruction and read back channels if the bitfile
+ exposes them, otherwise INSTR_CHNL for both.
+*/
+ChannelMap ChannelMap::forBoard(const fpga_info_list& info, int fid){
+	for(int i = 0; i < info.num_fpgas; i++){
+		if(info.id[i] == fid && info.num_chnls[i] > RDBACK_CHNL)
+			return ChannelMap(INSTR_CHNL, RDBACK_CHNL);
+	}
+
+	return ChannelMap();
+}
+
+RiffaBackend::RiffaBackend(fpga_t* fpga, const ChannelMap& chnls){
+	this->fpga = fpga;
+	this->chnls = chnls;
+}
+
+RiffaBackend::~RiffaBackend(){
+	fpga_close(fpga);
+}
+
+//! Opens and resets the RIFFA board with the given id.
+/*!
+  \param \e fid is the id of the board as reported by fpga_list.
+  \return The backend owning the opened board, or nullptr if the board
+ could not be opened.
+*/
+RiffaBackend* RiffaBackend::open(int fid){
+	fpga_info_list info;
+
+	if(fpga_list(&info) != 0)
+		return nullptr;
+
+	fpga_t* fpga = fpga_open(fid);
+
+	if(!fpga)
+		return nullptr;
+
+	fpga_reset(fpga); //recovers the FPGA from some unwanted state
+
+	return new RiffaBackend(fpga, ChannelMap::forBoard(info, fid));
+}
+
+int RiffaBackend::send(int chnl, void* data, int len){
+	return fpga_send(fpga, chnl, data, len, 0, 1, 0);
+}
+
+int RiffaBackend::recv(int chnl, void* data, int len, long long timeout){
+	return fpga_recv(fpga, chnl, data, len, timeout);
+}
+
+void RiffaBackend::reset(){
+	fpga_reset(fpga);
+}
+
+//! Allocates a buffer backed by 2 MiB pages to receive large amounts of data.
+/*!
+  The RIFFA driver maps physically contiguous pages with a single scatter
+ gather element, so receiving into a huge-page-backed buffer needs far fewer
+ scatter gather refills than a buffer of 4 KiB pages. Uses hugetlb pages if
+ the system has them reserved, otherwise a 2 MiB aligned buffer marked for
+ transparent huge pages.
+  \param \e bytes is the size of the buffer, rounded up to HUGE_PAGE_SIZE.
+  \return The buffer, or nullptr if it could not be allocated. Release it
+ with freeHugeBuffer.
+*/
+void* allocHugeBuffer(size_t bytes){
+	size_t len = (bytes + HUGE_PAGE_SIZE - 1) & ~((size_t)HUGE_PAGE_SIZE - 1);
+
+	void* buf = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if(buf != MAP_FAILED)
+		return buf;
+
+	// over-allocate so that the buffer can be aligned to a huge page
+	uint8_t* raw = (uint8_t*)mmap(nullptr, len + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(raw == MAP_FAILED)
+		return nullptr;
+
+	uint8_t* aligned = (uint8_t*)(((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~((uintptr_t)HUGE_PAGE_SIZE - 1));
+	if(aligned != raw)
+		munmap(raw, aligned - raw);
+	munmap(aligned + len, (raw + HUGE_PAGE_SIZE) - aligned);
+
+	madvise(aligned, len, MADV_HUGEPAGE);
+
+	return aligned;
+}
+
+void freeHugeBuffer(void* buf, size_t bytes){
+	size_t len = (bytes + HUGE_PAGE_SIZE - 1) & ~((size_t)HUGE_PAGE_SIZE - 1);
+	munmap(buf, len);
 }
 
 //! Generates an instruction to \b activate the row at the given address.
@@ -28,6 +28,16 @@
 // TODO: modify the hardware to support 32-bit instructions.
 #define INSTR_SIZE 2 //2 words
 
+// capacity of the instruction buffer of the hardware, END included
+#define MAX_INSTRS 8192
+
+// RIFFA channels of the SoftMC endpoint (see riffa_adapter_v6_pcie_v2_5.v).
+// Bitfiles that expose a single channel carry both streams on INSTR_CHNL.
+#define INSTR_CHNL 0
+#define RDBACK_CHNL 1
+
+#define HUGE_PAGE_SIZE (2*1024*1024)
+
 #define NUM_ROWS 32768
 #define NUM_COLS 1024
 #define NUM_BANKS 8
@@ -70,6 +80,8 @@ enum class REGISTER {
 };
 
 
+class Backend;
+
 class InstructionSequence{
 
 	public:
@@ -78,7 +90,8 @@ class InstructionSequence{
 		virtual ~InstructionSequence();
 
 		void insert(const Instruction c);
-		void execute(fpga_t* fpga);
+		void execute(fpga_t* fpga, int chnl = INSTR_CHNL);
+		void execute(Backend* be);
 
 		uint size;
 		Instruction* instrs;
@@ -98,6 +111,56 @@ class DramAddr{
 		DramAddr(uint row, uint bank){ this->row = row; this->bank = bank;}
 };
 
+//! RIFFA channels used to talk to a SoftMC board.
+class ChannelMap{
+
+	public:
+		int instr;
+		int rdback;
+
+		ChannelMap() : ChannelMap(INSTR_CHNL, INSTR_CHNL){}
+		ChannelMap(int instr, int rdback){ this->instr = instr; this->rdback = rdback;}
+
+		static ChannelMap forBoard(const fpga_info_list& info, int fid);
+};
+
+//! Interface to a SoftMC board, or to a model of one.
+/*!
+  Lengths are in 4-byte words and the semantics follow fpga_send and
+  fpga_recv, so that code written against a Backend runs unmodified on a
+  real board and on the emulator.
+*/
+class Backend{
+
+	public:
+		ChannelMap chnls;
+
+		virtual ~Backend(){}
+
+		virtual int send(int chnl, void* data, int len) = 0;
+		virtual int recv(int chnl, void* data, int len, long long timeout = 0) = 0;
+		virtual void reset() = 0;
+};
+
+//! Backend for a SoftMC board attached through RIFFA.
+class RiffaBackend : public Backend{
+
+	public:
+		RiffaBackend(fpga_t* fpga, const ChannelMap& chnls);
+		virtual ~RiffaBackend();
+
+		static RiffaBackend* open(int fid);
+
+		int send(int chnl, void* data, int len);
+		int recv(int chnl, void* data, int len, long long timeout = 0);
+		void reset();
+
+		fpga_t* fpga;
+};
+
+void* allocHugeBuffer(size_t bytes);
+void freeHugeBuffer(void* buf, size_t bytes);
+
 Instruction genACT(uint bank, uint row);
 Instruction genPRE(uint bank, PRE_TYPE pt = PRE_TYPE::SINGLE);
 Instruction genWR(uint bank, uint col, uint8_t pattern, AUTO_PRECHARGE ap = AUTO_PRECHARGE::NO_AP, BURST_LENGTH bl = BURST_LENGTH::FIXED);
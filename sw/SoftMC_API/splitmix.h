@@ -0,0 +1,19 @@
+#ifndef SPLITMIX_H
+#define SPLITMIX_H
+
+#include <stdint.h>
+
+//! Advances the state \e x and returns its next pseudo-random output.
+/*!
+  splitmix64: fast, and every seed gives a good sequence, which is all the
+ emulator, the random row orders and the random data pattern need. The
+ outputs must not change, or seeded runs are no longer reproducible.
+*/
+static inline uint64_t splitmix64(uint64_t& x){
+	uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+#endif //SPLITMIX_H
@@ -0,0 +1,177 @@
+#include "stream.h"
+#include <map>
+
+using namespace std;
+
+// WAIT cycles after the last WR of a group: CWL (5), the burst (4) and tWR
+//(6) pass before the PRE, 4 of them in the WAIT that follows the WR
+#define STREAM_TWR_WAIT 11
+
+// WAIT cycles after the last RD of a group, for tRTP
+#define STREAM_TRTP_WAIT 4
+
+//! Writes or reads one row in each of a set of banks per group, as many
+//groups as fit in a sequence.
+/*!
+  The rows of a group are activated tRRD apart and accessed with back to back
+ bursts (tCCD apart), then precharged together. The sequence is generated
+ once per set of banks; placing it on other rows only rewrites the ACTs.
+*/
+class StreamTemplate{
+
+	public:
+		StreamTemplate(uint8_t mask, bool write, uint8_t pattern);
+		~StreamTemplate(){ delete iseq; }
+
+		void place(uint group, const uint* rows);
+		void run(Backend* be, uint groups);
+
+		vector<uint> banks;
+		uint groups; //groups per sequence
+		uint64_t cycles; //issue cycles of a group
+		uint64_t data_cycles; //cycles of a group the data bus is busy
+
+	private:
+		uint per_group; //instructions per group
+		InstructionSequence* iseq;
+};
+
+StreamTemplate::StreamTemplate(uint8_t mask, bool write, uint8_t pattern){
+	for(uint b = 0; b < NUM_BANKS; b++)
+		if(mask & (1 << b))
+			banks.push_back(b);
+
+	uint n = banks.size();
+	uint tail = write ? STREAM_TWR_WAIT : STREAM_TRTP_WAIT;
+	per_group = 2*n + 2*BURSTS_PER_ROW*n + 3;
+	groups = (MAX_INSTRS - 1)/per_group;
+	data_cycles = (uint64_t)TCCD_CYCLES*BURSTS_PER_ROW*n;
+	cycles = TRRD_CYCLES*n + (n == 1 ? 2 : 0) + data_cycles + tail + 1 + 5;
+
+	iseq = new InstructionSequence(MAX_INSTRS);
+	for(uint g = 0; g < groups; g++){
+		for(uint i = 0; i < n; i++){
+			iseq->insert(genACT(banks[i], 0));
+
+			//Wait for tRRD, a single row waits for tRCD (the first row
+			//of a larger group is activated long enough before its burst)
+			iseq->insert(genWAIT(n == 1 ? 5 : TRRD_CYCLES - 1));
+		}
+
+		for(uint b : banks){
+			for(int i = 0; i < NUM_COLS; i+=8){ //we use 8x burst mode
+				iseq->insert(write ? genWR(b, i, pattern) : genRD(b, i));
+
+				//Wait for tCCD
+				iseq->insert(genWAIT(TCCD_CYCLES - 1));
+			}
+		}
+
+		//Wait for the last burst and tWR or tRTP
+		iseq->insert(genWAIT(tail));
+
+		iseq->insert(genPRE(0, PRE_TYPE::ALL));
+
+		//Wait for tRP
+		iseq->insert(genWAIT(5));
+	}
+
+	//START Transaction
+	iseq->insert(genEND());
+}
+
+//! Places a group on the given rows, one per bank of the template in
+//increasing bank order.
+void StreamTemplate::place(uint group, const uint* rows){
+	Instruction* instrs = iseq->instrs + group*per_group;
+	for(uint i = 0; i < banks.size(); i++)
+		instrs[2*i] = genACT(banks[i], rows[i]%NUM_ROWS);
+}
+
+//! Sends the first \e groups groups. Groups past them have to be placed again
+//before they are used.
+void StreamTemplate::run(Backend* be, uint groups){
+	uint end = groups*per_group;
+	iseq->instrs[end] = genEND();
+	iseq->size = end + 1;
+
+	iseq->execute(be);
+}
+
+StreamPlan::StreamPlan(const RowOrder& order){
+	vector<uint> banks[NUM_BANKS];
+	for(uint i = 0; i < order.size(); i++){
+		uint r = order.at(i);
+		banks[r/NUM_ROWS].push_back(r);
+	}
+
+	rows.reserve(order.size());
+	for(size_t i = 0; ; i++){
+		uint8_t mask = 0;
+		for(uint b = 0; b < NUM_BANKS; b++){
+			if(i < banks[b].size()){
+				rows.push_back(banks[b][i]);
+				mask |= 1 << b;
+			}
+		}
+
+		if(mask == 0)
+			break;
+		masks.push_back(mask);
+	}
+}
+
+//! Writes the pattern to, or reads, the rows of the plan at the peak
+//bandwidth of the DRAM bus.
+/*!
+  The hardware has no loops or address auto-increment, so the rows are
+ accessed with templates (see StreamTemplate) that are patched with the rows
+ of each group. The bus has to be turned to the right direction before.
+  \param \e sent, if given, is called with the number of rows of each
+ sequence once it has been sent.
+*/
+StreamStats streamRows(Backend* be, const StreamPlan& plan, const bool write, const uint8_t pattern,
+		const function<void(uint)>& sent){
+
+	map<uint8_t, StreamTemplate*> templates;
+	StreamStats st;
+
+	StreamTemplate* t = nullptr;
+	uint used = 0, rows = 0;
+	const uint* next = plan.rows.data();
+
+	auto run = [&](){
+		t->run(be, used);
+		if(sent)
+			sent(rows);
+		used = 0;
+		rows = 0;
+	};
+
+	for(uint8_t mask : plan.masks){
+		StreamTemplate*& nt = templates[mask];
+		if(nt == nullptr)
+			nt = new StreamTemplate(mask, write, pattern);
+
+		if(nt != t && used)
+			run();
+		t = nt;
+
+		t->place(used++, next);
+		next += t->banks.size();
+		rows += t->banks.size();
+		st.cycles += t->cycles;
+		st.data_cycles += t->data_cycles;
+
+		if(used == t->groups)
+			run();
+	}
+
+	if(used)
+		run();
+
+	for(auto& kv : templates)
+		delete kv.second;
+
+	return st;
+}
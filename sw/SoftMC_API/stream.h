@@ -0,0 +1,44 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <functional>
+#include <vector>
+#include "rowops.h"
+#include "roworder.h"
+
+// DDR3-800 on a 64-bit bus: 800 MT/s x 8 bytes
+#define DDR3_PEAK_GBPS 6.4
+#define CYCLE_NS 2.5
+
+//! The rows of an order arranged in groups of at most one row per bank,
+//the way streamRows accesses them.
+/*!
+  Every group takes the next row of each bank that still has rows, in the
+ order they appear in the order, so all banks are accessed in the same
+ sequence whatever the order.
+*/
+class StreamPlan{
+
+	public:
+		StreamPlan(const RowOrder& order);
+
+		std::vector<uint> rows; //linear rows, in the order they are accessed
+		std::vector<uint8_t> masks; //banks of each group
+};
+
+//! Issue and data bus cycles of the sequences streamRows sent.
+class StreamStats{
+
+	public:
+		uint64_t cycles;
+		uint64_t data_cycles;
+
+		StreamStats(){ cycles = 0; data_cycles = 0; }
+
+		double busEfficiency() const { return cycles ? (double)data_cycles/cycles : 0; }
+};
+
+StreamStats streamRows(Backend* be, const StreamPlan& plan, const bool write, const uint8_t pattern,
+		const std::function<void(uint)>& sent = nullptr);
+
+#endif //STREAM_H
@@ -0,0 +1,175 @@
+#include "sweep.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+
+using namespace std;
+
+//! A row group of a retention target that has been written and waits to be read.
+class InFlight{
+
+	public:
+		uint target;
+		uint group;
+		uint64_t deadline; //DeadlineScheduler::now() time
+};
+
+//! Tests the rows against several retention times in a single pipelined pass.
+/*!
+  Every group of \e group_rows rows is tested once for each retention time.
+ Instead of waiting for a group to age, the bus keeps writing other groups
+ and reads each group back as soon as its deadline passes, so groups of all
+ targets share one timeline. Groups of the longest targets are started
+ first, a group is never in flight for two targets at the same time, and a
+ new group is written only if that will not delay a pending read.
+  \param \e retentions are the retention times in milliseconds.
+  \param \e sink receives every mismatching byte with its retention time.
+  \param \e ckpt, if given, skips the groups it has completed and records the
+ groups that this run completes. Use the same \e group_rows when resuming.
+  \return The read back delays of every target, in the order of \e retentions.
+*/
+vector<SweepStats> sweepRetention(Backend* be, const vector<int>& retentions,
+		const DramAddr& first, const uint num_rows, const uint8_t pattern, const SweepSink& sink,
+		const uint group_rows, const bool progress, Checkpoint* ckpt){
+
+	return sweepRetention(be, retentions, RangeOrder(first, num_rows), pattern, sink, group_rows,
+			progress, ckpt);
+}
+
+//! Runs the sweep on the rows of \e order; consecutive rows of the order form
+//the row groups.
+vector<SweepStats> sweepRetention(Backend* be, const vector<int>& retentions,
+		const RowOrder& order, const uint8_t pattern, const SweepSink& sink,
+		const uint group_rows, const bool progress, Checkpoint* ckpt){
+
+	return sweepRetention(be, retentions, order, [pattern](uint, uint8_t* bursts){ memset(bursts, pattern, BURSTS_PER_ROW); },
+			sink, group_rows, progress, ckpt);
+}
+
+//! Runs the sweep with a pattern per row, e.g. a different data pattern in
+//each bank.
+vector<SweepStats> sweepRetention(Backend* be, const vector<int>& retentions,
+		const RowOrder& order, const RowPattern& pattern, const SweepSink& sink,
+		const uint group_rows, const bool progress, Checkpoint* ckpt){
+
+	uint num_groups = (order.size() + group_rows - 1)/group_rows;
+
+	vector<SweepStats> stats;
+	for(int r : retentions)
+		stats.push_back(SweepStats(r));
+
+	// targets in decreasing retention time, each with the next group to write
+	vector<uint> targets(retentions.size());
+	for(uint i = 0; i < targets.size(); i++)
+		targets[i] = i;
+	sort(targets.begin(), targets.end(), [&](uint a, uint b){ return retentions[a] > retentions[b]; });
+
+	vector<uint> next(retentions.size(), 0);
+	vector<char> busy(num_groups, 0);
+	vector<pair<uint, uint>> skip; //(target, group) completed by a previous run, sorted
+	multimap<uint64_t, InFlight> flights;
+	DeadlineScheduler sched;
+
+	InstructionSequence* iseq = nullptr;
+	vector<uint> rows(group_rows);
+	uint64_t write_time = 0; //of the last written group, in ns
+	uint done = 0, total = num_groups*retentions.size();
+
+	auto groupRows = [&](uint g){
+		uint n = 0;
+		for(uint i = g*group_rows; n < group_rows && i < order.size(); i++)
+			rows[n++] = order.at(i);
+		return n;
+	};
+
+	// skip the groups that a previous run has completed
+	if(ckpt){
+		for(uint t = 0; t < retentions.size(); t++){
+			for(uint g = 0; g < num_groups; g++){
+				uint n = groupRows(g);
+				if(all_of(rows.begin(), rows.begin() + n, [&](uint r){ return ckpt->isDone(retentions[t], r); })){
+					skip.push_back(make_pair(t, g));
+					done++;
+				}
+			}
+		}
+	}
+
+	while(done < total){
+		uint64_t now = DeadlineScheduler::now();
+
+		// read back the groups that are due
+		if(!flights.empty() && flights.begin()->first <= now){
+			InFlight f = flights.begin()->second;
+			flights.erase(flights.begin());
+
+			double late = (now - f.deadline)/1e6;
+			SweepStats& st = stats[f.target];
+			st.groups++;
+			st.total_late_ms += late;
+			st.max_late_ms = max(st.max_late_ms, late);
+
+			int retention = retentions[f.target];
+			uint n = groupRows(f.group);
+			readRowGroup(be, rows.data(), n, pattern,
+					[&sink, retention](const ReadError& e){ sink(retention, e); }, iseq);
+
+			busy[f.group] = 0;
+			done++;
+
+			if(ckpt)
+				ckpt->complete(retention, rows.data(), n);
+
+			if(progress){
+				printf("%c[2K\r", 27);
+				printf("Completed %u of %u row groups", done, total);
+				fflush(stdout);
+			}
+			continue;
+		}
+
+		// pick the longest target whose next group is idle
+		int t = -1;
+		for(uint i : targets){
+			while(next[i] < num_groups && binary_search(skip.begin(), skip.end(), make_pair(i, next[i])))
+				next[i]++;
+
+			if(next[i] < num_groups && !busy[next[i]]){
+				t = i;
+				break;
+			}
+		}
+
+		// write it unless that would make the earliest pending read late
+		if(t >= 0 && (flights.empty() || now + write_time <= flights.begin()->first)){
+			uint g = next[t]++;
+			uint n = groupRows(g);
+
+			InFlight f;
+			f.target = t;
+			f.group = g;
+			f.deadline = now + retentions[t]*1000000ULL;
+
+			writeRowGroup(be, rows.data(), n, pattern, iseq);
+			write_time = DeadlineScheduler::now() - now;
+
+			busy[g] = 1;
+			flights.emplace(f.deadline, f);
+			continue;
+		}
+
+		if(!flights.empty())
+			sched.waitUntil(flights.begin()->first);
+	}
+
+	if(ckpt)
+		ckpt->sync();
+
+	if(progress)
+		printf("\n");
+
+	delete iseq;
+	return stats;
+}
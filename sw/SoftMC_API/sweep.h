@@ -0,0 +1,36 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <vector>
+#include "retention.h"
+
+// rows written and read back together by sweepRetention
+#define SWEEP_GROUP_ROWS 16
+
+//! Receives the errors of sweepRetention with the retention time they were found at.
+typedef std::function<void(int retention, const ReadError&)> SweepSink;
+
+//! Timing of a retention target in a sweep.
+class SweepStats{
+
+	public:
+		int retention;
+		uint groups;
+		double max_late_ms; //longest delay of a read after its deadline
+		double total_late_ms;
+
+		SweepStats() : SweepStats(0){}
+		SweepStats(int retention){ this->retention = retention; groups = 0; max_late_ms = total_late_ms = 0; }
+};
+
+std::vector<SweepStats> sweepRetention(Backend* be, const std::vector<int>& retentions,
+		const DramAddr& first, const uint num_rows, const uint8_t pattern, const SweepSink& sink,
+		const uint group_rows = SWEEP_GROUP_ROWS, const bool progress = false, Checkpoint* ckpt = nullptr);
+std::vector<SweepStats> sweepRetention(Backend* be, const std::vector<int>& retentions,
+		const RowOrder& order, const uint8_t pattern, const SweepSink& sink,
+		const uint group_rows = SWEEP_GROUP_ROWS, const bool progress = false, Checkpoint* ckpt = nullptr);
+std::vector<SweepStats> sweepRetention(Backend* be, const std::vector<int>& retentions,
+		const RowOrder& order, const RowPattern& pattern, const SweepSink& sink,
+		const uint group_rows = SWEEP_GROUP_ROWS, const bool progress = false, Checkpoint* ckpt = nullptr);
+
+#endif //SWEEP_H
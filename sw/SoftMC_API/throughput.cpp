@@ -0,0 +1,76 @@
+#include "throughput.h"
+#include "retention.h"
+#include "scheduler.h"
+
+ThroughputModel::ThroughputModel(double max_error_ms){
+	this->max_error_ms = max_error_ms;
+	alpha = 0.2;
+
+	//writing the entire row takes approximately 5 ms
+	write_ms = read_ms = 5.0;
+	write_samples = read_samples = 0;
+}
+
+//! Measures the write and read times of CALIBRATION_ROWS rows from \e first.
+/*!
+  The rows are overwritten with \e pattern.
+*/
+void ThroughputModel::calibrate(Backend* be, const DramAddr& first, const uint8_t pattern){
+	InstructionSequence* iseq = nullptr;
+	uint rows[CALIBRATION_ROWS];
+	uint first_row = first.bank*NUM_ROWS + first.row;
+	uint n = 0;
+
+	for(; n < CALIBRATION_ROWS && first_row + n < NUM_DIMM_ROWS; n++)
+		rows[n] = first_row + n;
+
+	uint64_t t0 = DeadlineScheduler::now();
+	writeRowGroup(be, rows, n, pattern, iseq);
+	uint64_t t1 = DeadlineScheduler::now();
+	readRowGroup(be, rows, n, pattern, [](const ReadError&){}, iseq);
+	uint64_t t2 = DeadlineScheduler::now();
+
+	// calibration replaces the initial guesses
+	write_samples = read_samples = 0;
+	observeWrite(n, (t1 - t0)/1e6);
+	observeRead(n, (t2 - t1)/1e6);
+
+	delete iseq;
+}
+
+void ThroughputModel::observeWrite(uint rows, double ms){
+	if(rows == 0)
+		return;
+
+	write_ms = write_samples++ ? alpha*ms/rows + (1 - alpha)*write_ms : ms/rows;
+}
+
+void ThroughputModel::observeRead(uint rows, double ms){
+	if(rows == 0)
+		return;
+
+	read_ms = read_samples++ ? alpha*ms/rows + (1 - alpha)*read_ms : ms/rows;
+}
+
+//! Returns how much longer (in ms) than the retention time the rows of a
+//group of the given size age.
+double ThroughputModel::agingError(uint rows, int retention) const{
+	double overrun = rows*rowPeriod() - retention;
+	return overrun > 0 ? overrun : 0;
+}
+
+//! Returns the largest group that keeps the aging error within max_error_ms
+//(at least one row).
+uint ThroughputModel::groupSize(int retention) const{
+	uint lo = 1, hi = NUM_DIMM_ROWS;
+
+	while(lo < hi){
+		uint mid = lo + (hi - lo + 1)/2;
+		if(agingError(mid, retention) <= max_error_ms)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	return lo;
+}
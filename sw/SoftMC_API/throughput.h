@@ -0,0 +1,47 @@
+#ifndef THROUGHPUT_H
+#define THROUGHPUT_H
+
+#include "rowops.h"
+
+// rows written and read back by ThroughputModel::calibrate
+#define CALIBRATION_ROWS 16
+// default bound on how much longer than the target a row may age
+#define MAX_AGING_ERROR_MS 2.0
+
+//! Per-row write and read times of a board, used to size row groups.
+/*!
+  testRetentionGroup writes and reads one row every rowPeriod(), the
+ longer of write_ms and read_ms, so every row of a group ages the same
+ time however much slower one phase is. That time exceeds the target by
+ max(0, n*rowPeriod() - retention) when writing a group of n rows takes
+ longer than the retention time, so groupSize() returns the largest n for
+ which that stays within max_error_ms. The times are moving averages of
+ the time spent writing and reading, without the pacing, that are updated
+ after every group.
+*/
+class ThroughputModel{
+
+	public:
+		double write_ms; //per row
+		double read_ms; //per row, including the comparison
+		double max_error_ms;
+		double alpha; //weight of a new observation
+
+		ThroughputModel(double max_error_ms = MAX_AGING_ERROR_MS);
+
+		void calibrate(Backend* be, const DramAddr& first, const uint8_t pattern);
+		void observeWrite(uint rows, double ms);
+		void observeRead(uint rows, double ms);
+
+		double rowPeriod() const { return write_ms > read_ms ? write_ms : read_ms; }
+		double agingError(uint rows, int retention) const;
+		uint groupSize(int retention) const;
+
+		bool calibrated() const { return write_samples > 0 && read_samples > 0; }
+
+	private:
+		uint write_samples;
+		uint read_samples;
+};
+
+#endif //THROUGHPUT_H
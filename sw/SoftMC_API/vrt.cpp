@@ -0,0 +1,94 @@
+#include "vrt.h"
+#include "cellmap.h"
+#include "scheduler.h"
+#include "sweep.h"
+#include <stdio.h>
+
+using namespace std;
+
+VrtMonitor::VrtMonitor(uint32_t retention_ms){
+	this->retention_ms = retention_ms;
+	passes = 0;
+}
+
+//! Adds the rows and cells of the database that failed at the retention time
+//or a shorter one.
+void VrtMonitor::track(const WeakCellDb& db){
+	rows = db.weakRows(retention_ms);
+
+	db.forEach([this](const CellStats& s){
+		if(s.min_fail_ms <= retention_ms && !cells.count(s.cell))
+			cells[s.cell] = VrtCell(s.cell, CELL_STATE::UNKNOWN);
+	});
+}
+
+//! Tests the tracked rows \e passes times, starting a pass every \e period_ms.
+/*!
+  Each pass is a pipelined retention test of the tracked rows (see
+ sweepRetention). If a pass takes longer than the period, the next one
+ starts right after it.
+  \param \e sink receives every transition, as soon as its pass ends.
+  \param \e errors, if given, receives every mismatching byte.
+*/
+void VrtMonitor::run(Backend* be, const uint passes, const uint period_ms, const uint8_t pattern,
+		const VrtSink& sink, const ErrorSink& errors, const bool progress){
+
+	ListOrder order(rows);
+	vector<int> retention(1, retention_ms);
+	DeadlineScheduler sched;
+	uint64_t start = DeadlineScheduler::now();
+
+	for(uint p = 0; p < passes; p++){
+		if(p)
+			sched.waitUntil(start + (uint64_t)p*period_ms*1000000ULL);
+
+		if(progress){
+			printf("%c[2K\r", 27);
+			printf("Pass %u of %u", p + 1, passes);
+			fflush(stdout);
+		}
+
+		CellBitmap failed;
+		sweepRetention(be, retention, order, pattern, [&](int, const ReadError& e){
+			failed.insert(e);
+			if(errors)
+				errors(e);
+		});
+
+		double elapsed = (DeadlineScheduler::now() - start)/1e6;
+
+		// cells that fail for the first time passed in the earlier passes
+		failed.forEach([&](uint64_t c){
+			if(!cells.count(c))
+				cells[c] = VrtCell(c, this->passes ? CELL_STATE::PASS : CELL_STATE::UNKNOWN);
+		});
+
+		for(auto& kv : cells){
+			VrtCell& c = kv.second;
+			CELL_STATE s = failed.contains(c.cell) ? CELL_STATE::FAIL : CELL_STATE::PASS;
+			if(s == CELL_STATE::FAIL)
+				c.fails++;
+
+			if(c.state != CELL_STATE::UNKNOWN && c.state != s){
+				c.transitions++;
+				sink(VrtTransition(c.cell, this->passes, elapsed, c.state, s));
+			}
+			c.state = s;
+		}
+
+		this->passes++;
+	}
+
+	if(progress)
+		printf("\n");
+}
+
+//! Returns the number of tracked cells that changed their state at least once.
+uint VrtMonitor::vrtCells() const{
+	uint n = 0;
+	for(const auto& kv : cells)
+		if(kv.second.transitions)
+			n++;
+
+	return n;
+}
@@ -0,0 +1,70 @@
+#ifndef VRT_H
+#define VRT_H
+
+#include <map>
+#include <vector>
+#include "weakcells.h"
+#include "roworder.h"
+
+enum class CELL_STATE {
+	UNKNOWN = 0, //not tested yet
+	PASS = 1,
+	FAIL = 2
+};
+
+//! A monitored cell that changed its state between two passes.
+class VrtTransition{
+
+	public:
+		uint64_t cell; //CellBitmap::cellIndex
+		uint pass;
+		double elapsed_ms; //since the monitor started
+		CELL_STATE from;
+		CELL_STATE to;
+
+		VrtTransition(uint64_t cell, uint pass, double elapsed_ms, CELL_STATE from, CELL_STATE to){
+			this->cell = cell; this->pass = pass; this->elapsed_ms = elapsed_ms; this->from = from; this->to = to;
+		}
+};
+
+typedef std::function<void(const VrtTransition&)> VrtSink;
+
+//! History of a monitored cell.
+class VrtCell{
+
+	public:
+		uint64_t cell;
+		CELL_STATE state;
+		uint fails; //passes the cell failed in
+		uint transitions;
+
+		VrtCell() : VrtCell(0, CELL_STATE::UNKNOWN){}
+		VrtCell(uint64_t cell, CELL_STATE state){ this->cell = cell; this->state = state; fails = 0; transitions = 0; }
+};
+
+//! Re-tests the rows of known weak cells at a fixed cadence to catch cells
+//with variable retention times (VRT).
+/*!
+  The monitor tests only the rows that have a cell that failed at the
+ retention time before, so a pass costs a fraction of a full DIMM test.
+ Every cell of those rows that fails in a pass is tracked from then on, and
+ a change of its state from one pass to the next is a transition.
+*/
+class VrtMonitor{
+
+	public:
+		VrtMonitor(uint32_t retention_ms);
+
+		void track(const WeakCellDb& db);
+		void run(Backend* be, const uint passes, const uint period_ms, const uint8_t pattern,
+				const VrtSink& sink, const ErrorSink& errors = nullptr, const bool progress = false);
+
+		uint vrtCells() const;
+
+		uint32_t retention_ms;
+		std::vector<DramAddr> rows; //bank major
+		std::map<uint64_t, VrtCell> cells;
+		uint passes; //completed
+};
+
+#endif //VRT_H
@@ -0,0 +1,160 @@
+#include "weakcells.h"
+#include "cellmap.h"
+#include <algorithm>
+
+using namespace std;
+
+void CellStats::merge(const CellStats& s){
+	min_fail_ms = min(min_fail_ms, s.min_fail_ms);
+	max_fail_ms = max(max_fail_ms, s.max_fail_ms);
+	fails += s.fails;
+	last_run = max(last_run, s.last_run);
+}
+
+WeakCellDb::WeakCellDb(){
+	file = nullptr;
+	entries = 0;
+}
+
+WeakCellDb::~WeakCellDb(){
+	close();
+}
+
+//! Loads the database and opens it for appending. A missing file is created.
+/*!
+  A partially written entry at the end of the file (e.g. after a crash) is
+  ignored and overwritten by the next commit.
+*/
+bool WeakCellDb::open(const char* path){
+	close();
+	this->path = path;
+
+	FILE* f = fopen(path, "rb");
+	uint64_t valid = 0;
+	if(f){
+		CellStats buf[4096];
+		size_t n;
+		while((n = fread(buf, sizeof(CellStats), 4096, f)) > 0){
+			for(size_t i = 0; i < n; i++)
+				update(buf[i]);
+			valid += n;
+		}
+		fclose(f);
+	}
+
+	file = fopen(path, valid ? "r+b" : "wb");
+	if(!file)
+		return false;
+
+	// drop a torn entry
+	fseek(file, valid*sizeof(CellStats), SEEK_SET);
+	entries = valid;
+	return true;
+}
+
+void WeakCellDb::close(){
+	if(!file)
+		return;
+
+	commit();
+	fclose(file);
+	file = nullptr;
+
+	cells.clear();
+	entries = 0;
+	row_min.clear();
+}
+
+void WeakCellDb::update(const CellStats& s){
+	auto it = cells.find(s.cell);
+	if(it == cells.end())
+		cells.emplace(s.cell, s);
+	else
+		it->second.merge(s);
+
+	uint32_t row = s.cell / BITS_PER_COL / NUM_COLS;
+	auto r = row_min.find(row);
+	if(r == row_min.end())
+		row_min.emplace(row, s.min_fail_ms);
+	else
+		r->second = min(r->second, s.min_fail_ms);
+}
+
+//! Records every bit in which the read data differs from the expected one.
+void WeakCellDb::record(const ReadError& err, uint32_t retention_ms, uint32_t run_id){
+	uint8_t diff = err.data ^ err.expected;
+
+	for(uint b = 0; b < 8; b++){
+		if(!(diff & (1 << b)))
+			continue;
+
+		CellStats s(CellBitmap::cellIndex(DramAddr(err.row, err.bank), err.col, err.lane, b),
+				retention_ms, retention_ms, 1, run_id);
+		update(s);
+		pending.push_back(s);
+	}
+}
+
+//! Appends the failures recorded since the last commit to the file.
+bool WeakCellDb::commit(){
+	if(!file)
+		return false;
+
+	bool ok = fwrite(pending.data(), sizeof(CellStats), pending.size(), file) == pending.size();
+	ok = (fflush(file) == 0) && ok;
+	entries += pending.size();
+	pending.clear();
+
+	return ok;
+}
+
+//! Rewrites the file with a single entry per cell.
+bool WeakCellDb::compact(){
+	if(!file)
+		return false;
+
+	string tmp = path + ".tmp";
+	FILE* f = fopen(tmp.c_str(), "wb");
+	if(!f)
+		return false;
+
+	bool ok = true;
+	for(const auto& c : cells)
+		ok = ok && fwrite(&c.second, sizeof(CellStats), 1, f) == 1;
+
+	ok = (fclose(f) == 0) && ok;
+	if(!ok || rename(tmp.c_str(), path.c_str()) != 0){
+		remove(tmp.c_str());
+		return false;
+	}
+
+	fclose(file);
+	file = fopen(path.c_str(), "ab");
+	pending.clear();
+	entries = cells.size();
+
+	return file != nullptr;
+}
+
+const CellStats* WeakCellDb::find(uint64_t cell) const{
+	auto it = cells.find(cell);
+	return it == cells.end() ? nullptr : &it->second;
+}
+
+//! Returns the shortest retention time any cell of the row failed at, or
+//NO_FAILURE if none of them did.
+uint32_t WeakCellDb::rowMinFailure(const DramAddr& addr) const{
+	auto it = row_min.find(addr.bank*NUM_ROWS + addr.row);
+	return it == row_min.end() ? NO_FAILURE : it->second;
+}
+
+//! Returns the rows, in bank major order, that have a cell that failed at
+//the given retention time or a shorter one.
+vector<DramAddr> WeakCellDb::weakRows(uint32_t retention_ms) const{
+	vector<DramAddr> rows;
+	for(const auto& r : row_min)
+		if(r.second <= retention_ms)
+			rows.push_back(DramAddr(r.first % NUM_ROWS, r.first / NUM_ROWS));
+
+	return rows;
+}
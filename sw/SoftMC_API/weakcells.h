@@ -0,0 +1,76 @@
+#ifndef WEAKCELLS_H
+#define WEAKCELLS_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include "rowops.h"
+
+//! What is known about a cell that failed at least once.
+class CellStats{
+
+	public:
+		uint64_t cell; //CellBitmap::cellIndex
+		uint32_t min_fail_ms; //shortest retention time the cell failed at
+		uint32_t max_fail_ms; //longest retention time the cell failed at
+		uint32_t fails; //number of observed failures
+		uint32_t last_run;
+
+		CellStats() : CellStats(0, NO_FAILURE, 0, 0, 0){}
+		CellStats(uint64_t cell, uint32_t min_fail_ms, uint32_t max_fail_ms, uint32_t fails, uint32_t last_run){
+			this->cell = cell; this->min_fail_ms = min_fail_ms; this->max_fail_ms = max_fail_ms;
+			this->fails = fails; this->last_run = last_run;
+		}
+
+		void merge(const CellStats& s);
+};
+
+static_assert(sizeof(CellStats) == 24, "CellStats is stored as is");
+
+//! Persistent per-DIMM database of the cells that failed in retention runs.
+/*!
+  The file is a sequence of CellStats entries. Every commit appends one
+  entry per cell that failed since the previous commit, and loading merges
+  the entries of the same cell, so an interrupted run loses at most its
+  uncommitted failures. compact() rewrites the file with a single entry per
+  cell. Use a separate database per DIMM (and per temperature, if the
+  results should not be mixed).
+*/
+class WeakCellDb{
+
+	public:
+		WeakCellDb();
+		virtual ~WeakCellDb();
+
+		bool open(const char* path);
+		void close();
+
+		void record(const ReadError& err, uint32_t retention_ms, uint32_t run_id);
+		bool commit();
+		bool compact();
+
+		size_t size() const { return cells.size(); }
+		uint64_t fileEntries() const { return entries; }
+		const CellStats* find(uint64_t cell) const;
+
+		uint32_t rowMinFailure(const DramAddr& addr) const;
+		std::vector<DramAddr> weakRows(uint32_t retention_ms) const;
+
+		template<typename F>
+		void forEach(F f) const { for(const auto& c : cells) f(c.second); }
+
+	private:
+		void update(const CellStats& s);
+
+		std::string path;
+		FILE* file;
+
+		std::unordered_map<uint64_t, CellStats> cells;
+		std::map<uint32_t, uint32_t> row_min; //linear row -> shortest failing retention
+		std::vector<CellStats> pending; //not yet appended to the file
+		uint64_t entries; //in the file
+};
+
+#endif //WEAKCELLS_H
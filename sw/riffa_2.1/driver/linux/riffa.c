@@ -122,6 +122,38 @@ void fpga_reset(fpga_t * fpga)
 	ioctl(fpga->fd, IOCTL_RESET, fpga->id);
 }
 
+int fpga_chnl_pollfd(fpga_t * fpga, int chnl)
+{
+	fpga_chnl_evt evt;
+	int fd;
+
+	// Each channel gets its own descriptor so that poll can tell them apart.
+	fd = open("/dev/" DEVICE_NAME, O_RDWR | O_SYNC);
+	if (fd < 0)
+		return fd;
+
+	evt.id = fpga->id;
+	evt.chnl = chnl;
+	evt.fd = -1;
+	if (ioctl(fd, IOCTL_POLL_BIND, &evt) != 0) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+int fpga_chnl_eventfd(fpga_t * fpga, int chnl, int efd)
+{
+	fpga_chnl_evt evt;
+
+	evt.id = fpga->id;
+	evt.chnl = chnl;
+	evt.fd = efd;
+
+	return ioctl(fpga->fd, IOCTL_SET_EVENTFD, &evt);
+}
+
 int fpga_list(fpga_info_list * list) {
 	int fd;
 	int rc;
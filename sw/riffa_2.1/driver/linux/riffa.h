@@ -120,6 +120,26 @@ int fpga_recv(fpga_t * fpga, int chnl, void * data, int len, long long timeout);
  */
 void fpga_reset(fpga_t * fpga);
 
+/**
+ * Returns a new file descriptor bound to FPGA channel chnl that can be used 
+ * with poll, select or epoll. The descriptor becomes readable (POLLIN) when the
+ * FPGA channel has started a transaction that has not yet been received with 
+ * fpga_recv. A single thread can therefore wait on many channels (and many 
+ * FPGAs) at once. The descriptor should be closed with close() when no longer 
+ * needed. On error returns a negative value.
+ */
+int fpga_chnl_pollfd(fpga_t * fpga, int chnl);
+
+/**
+ * Registers the eventfd descriptor efd with FPGA channel chnl. The eventfd 
+ * counter is incremented each time the FPGA starts a new transaction on the 
+ * channel. Transactions already pending at registration are counted too. Pass
+ * a negative efd to unregister. Only one eventfd can be registered per channel.
+ * The registration is dropped when fpga is closed. On success, returns 0. On 
+ * error returns a negative value.
+ */
+int fpga_chnl_eventfd(fpga_t * fpga, int chnl, int efd);
+
 #ifdef __cplusplus
 }
 #endif
@@ -61,6 +61,12 @@
 #include <linux/rwsem.h>
 #include <linux/dma-mapping.h>
 #include <linux/pagemap.h>
+#include <linux/poll.h>
+#include <linux/eventfd.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <asm/uaccess.h>
 #include <asm/div64.h>
 #include "riffa_driver.h"
@@ -77,6 +83,17 @@ MODULE_AUTHOR("Matt Jacobsen, Patrick Lai");
 #endif
 
 #define CHNL_REG(c, o) ((c<<4) + o)
+#define SG_POOL_SLOTS 2 // at most two sg_mappings are live per channel direction
+#define SG_MAX_PAGES 4096 // default max # of user pages pinned per SG refill
+#define SG_MAX_ELEM_LEN (1<<30) // max # of bytes covered by a single SG element
+
+// Module parameters
+static int sg_elems = SG_ELEMS;
+module_param(sg_elems, int, S_IRUGO);
+MODULE_PARM_DESC(sg_elems, "# of SG elements per refill, per 32 bits of bus width");
+static int sg_max_pages = SG_MAX_PAGES;
+module_param(sg_max_pages, int, S_IRUGO);
+MODULE_PARM_DESC(sg_max_pages, "max # of user pages pinned per SG refill");
 #if !defined(__LP64__) && !defined(_LP64)
 #define BUILD_32 1
 #endif
@@ -87,17 +104,26 @@ struct sg_mapping {
 	enum dma_data_direction direction;
 	int num_sg;
 	unsigned long num_pages;
+	int num_ents;
 	unsigned long long length;
 	unsigned long long overflow;
+	struct chnl_dir * pool;
+	int slot;
 };
 
 struct chnl_dir {
 	wait_queue_head_t waitq;
 	struct circ_queue * msgs;
+	atomic_t txns;
+	spinlock_t evt_lock;
+	struct eventfd_ctx * evt;
+	struct file * evt_filp;
 	void * buf_addr;
 	dma_addr_t buf_hw_addr;
 	struct sg_mapping * sg_map_0;
 	struct sg_mapping * sg_map_1;
+	struct sg_mapping sg_pool[SG_POOL_SLOTS];
+	unsigned long sg_pool_used;
 };
 
 struct fpga_state {
@@ -111,6 +137,7 @@ struct fpga_state {
 	void * spill_buf_addr;
 	dma_addr_t spill_buf_hw_addr;
 	int num_sg;
+	int max_pages;
 	int sg_buf_size;
 	int id;
 	char name[16];
@@ -119,6 +146,14 @@ struct fpga_state {
 	int num_chnls;
 	struct chnl_dir ** recv;
 	struct chnl_dir ** send;
+	atomic_t sg_pool_hits;
+	atomic_t sg_allocs;
+	struct dentry * debugfs_file;
+};
+
+struct file_binding {
+	int id;
+	int chnl;
 };
 
 // Global variables (to this file only)
@@ -126,6 +161,7 @@ static struct class * mymodule_class;
 static dev_t devt;
 static atomic_t used_fpgas[NUM_FPGAS];
 static struct fpga_state * fpgas[NUM_FPGAS];
+static struct dentry * debugfs_dir;
 
 ///////////////////////////////////////////////////////
 // MEMORY ALLOCATION & HELPER FUNCTIONS
@@ -159,6 +195,115 @@ unsigned long long __udivdi3(unsigned long long num, unsigned long long den)
 }
 #endif
 
+/**
+ * Preallocates the sg_mapping structs, pages arrays and scatterlists of the 
+ * channel direction, sized for sc->max_pages pages and sc->num_sg elements. Returns 0 on success,
+ * non-zero if there is not enough memory.
+ */
+static inline int init_sg_pool(struct fpga_state * sc, struct chnl_dir * cd)
+{
+	int i;
+
+	cd->sg_pool_used = 0;
+	for (i = 0; i < SG_POOL_SLOTS; ++i) {
+		cd->sg_pool[i].pool = cd;
+		cd->sg_pool[i].slot = i;
+		cd->sg_pool[i].pages = vmalloc(sc->max_pages * sizeof(struct page *));
+		cd->sg_pool[i].sgl = vmalloc(sc->num_sg * sizeof(struct scatterlist));
+		if (cd->sg_pool[i].pages == NULL || cd->sg_pool[i].sgl == NULL)
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * Frees the preallocated pool of the channel direction.
+ */
+static inline void free_sg_pool(struct chnl_dir * cd)
+{
+	int i;
+
+	for (i = 0; i < SG_POOL_SLOTS; ++i) {
+		vfree(cd->sg_pool[i].pages);
+		vfree(cd->sg_pool[i].sgl);
+	}
+}
+
+/**
+ * Returns an sg_mapping (with pages array for sc->max_pages pages and 
+ * scatterlist for sc->num_sg elements) from the pool of the channel direction. Falls back to allocating
+ * one if the pool is exhausted. Returns NULL if there is not enough memory.
+ */
+static inline struct sg_mapping * alloc_sg_map(struct fpga_state * sc, struct chnl_dir * cd)
+{
+	struct sg_mapping * sg_map;
+	int i;
+
+	for (i = 0; i < SG_POOL_SLOTS; ++i) {
+		if (!test_and_set_bit(i, &cd->sg_pool_used)) {
+			atomic_inc(&sc->sg_pool_hits);
+			return &cd->sg_pool[i];
+		}
+	}
+
+	atomic_inc(&sc->sg_allocs);
+	if ((sg_map = kmalloc(sizeof(*sg_map), GFP_KERNEL)) == NULL)
+		return NULL;
+	sg_map->pool = NULL;
+	sg_map->slot = -1;
+	sg_map->pages = vmalloc(sc->max_pages * sizeof(struct page *));
+	sg_map->sgl = vmalloc(sc->num_sg * sizeof(struct scatterlist));
+	if (sg_map->pages == NULL || sg_map->sgl == NULL) {
+		vfree(sg_map->pages);
+		vfree(sg_map->sgl);
+		kfree(sg_map);
+		return NULL;
+	}
+	return sg_map;
+}
+
+/**
+ * Returns the sg_mapping to the pool it came from, or frees it.
+ */
+static inline void release_sg_map(struct sg_mapping * sg_map)
+{
+	if (sg_map->pool != NULL) {
+		clear_bit(sg_map->slot, &sg_map->pool->sg_pool_used);
+		return;
+	}
+	vfree(sg_map->pages);
+	vfree(sg_map->sgl);
+	kfree(sg_map);
+}
+
+/**
+ * Prints the sg_mapping allocation counters of the FPGA to debugfs. Every pool
+ * hit saves the three allocations (and frees) of an sg_mapping.
+ */
+static int sg_pool_show(struct seq_file * m, void * v)
+{
+	struct fpga_state * sc = (struct fpga_state *)m->private;
+	int hits = atomic_read(&sc->sg_pool_hits);
+
+	seq_printf(m, "pool hits: %d\n", hits);
+	seq_printf(m, "pool misses: %d\n", atomic_read(&sc->sg_allocs));
+	seq_printf(m, "allocations saved: %d\n", 3*hits);
+	return 0;
+}
+
+static int sg_pool_open(struct inode * inode, struct file * file)
+{
+	return single_open(file, sg_pool_show, inode->i_private);
+}
+
+static const struct file_operations sg_pool_fops = {
+	.owner		= THIS_MODULE,
+	.open		= sg_pool_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 ///////////////////////////////////////////////////////
 // INTERRUPT HANDLER
 ///////////////////////////////////////////////////////
@@ -237,6 +382,13 @@ static inline void process_intr_vector(struct fpga_state * sc, int off,
 			if (push_circ_queue(sc->recv[chnl]->msgs, EVENT_TXN_LEN, len)) {
 				printk(KERN_ERR "riffa: fpga:%d chnl:%d, recv txn len msg queue full\n", sc->id, chnl);
 			}
+			// Notify any poll/eventfd listeners. Counted under the lock, so
+			// set_eventfd reports each transaction exactly once.
+			spin_lock(&sc->recv[chnl]->evt_lock);
+			atomic_inc(&sc->recv[chnl]->txns);
+			if (sc->recv[chnl]->evt != NULL)
+				eventfd_signal(sc->recv[chnl]->evt, 1);
+			spin_unlock(&sc->recv[chnl]->evt_lock);
 			DEBUG_MSG(KERN_INFO "riffa: fpga:%d chnl:%d, recv txn (len:%d off:%d last:%d)\n", sc->id, chnl, len, (offlast>>1), (offlast & 0x1));
 		}
 
@@ -322,12 +474,17 @@ static inline struct sg_mapping * fill_sg_buf(struct fpga_state * sc, int chnl,
 	void * sg_buf, unsigned long udata, unsigned long long length, 
 	unsigned long long overflow, enum dma_data_direction direction) {
 	const char * dir = (direction == DMA_TO_DEVICE ? "send" : "recv");
+	struct chnl_dir * cd = (direction == DMA_TO_DEVICE ? sc->send[chnl] : sc->recv[chnl]);
 	struct sg_mapping * sg_map;
 	struct page ** pages = NULL;
 	struct scatterlist * sgl = NULL;
 	struct scatterlist * sg;
 	unsigned long num_pages_reqd = 0;
+	unsigned long uaddr;
+	unsigned int max_elem_len = dma_get_max_seg_size(&sc->dev->dev);
 	long num_pages = 0;
+	long pinned;
+	int num_ents = 0;
 	unsigned int fp_offset;
 	unsigned int len;
 	unsigned int hw_len;
@@ -337,56 +494,72 @@ static inline struct sg_mapping * fill_sg_buf(struct fpga_state * sc, int chnl,
 	unsigned int * sg_buf_ptr = (unsigned int *)sg_buf;
 	int num_sg = 0;
 	int i;
+	int j;
 
-	// Create the sg_mapping struct.
-	if ((sg_map = (struct sg_mapping *)kmalloc(sizeof(*sg_map), GFP_KERNEL)) == NULL) {
+	// Get an sg_mapping struct with pages array and scatterlist from the pool.
+	if ((sg_map = alloc_sg_map(sc, cd)) == NULL) {
 		printk(KERN_ERR "riffa: fpga:%d chnl:%d, %s could not allocate memory for sg_mapping struct\n", sc->id, chnl, dir);
 		return NULL;
 	}
 
 	if (length > 0) {
-		// Create the pages array.
-		num_pages_reqd = ((udata + length - 1)>>PAGE_SHIFT) - (udata>>PAGE_SHIFT) + 1;
-		num_pages_reqd = (num_pages_reqd > sc->num_sg ? sc->num_sg : num_pages_reqd);
-		if ((pages = kmalloc(num_pages_reqd * sizeof(*pages), GFP_KERNEL)) == NULL) {
-			printk(KERN_ERR "riffa: fpga:%d chnl:%d, %s could not allocate memory for pages array\n", sc->id, chnl, dir);
-			kfree(sg_map);
-			return NULL;
-		}
+		pages = sg_map->pages;
+		sgl = sg_map->sgl;
+		sg_init_table(sgl, sc->num_sg);
+		fp_offset = (udata & (~PAGE_MASK));
+
+		// Pin the user pages a chunk at a time. Physically contiguous pages 
+		// (e.g. huge pages) are merged into a single scatterlist element, so 
+		// keep pinning until the elements or the pages array run out.
+		while (len_rem > 0 && num_ents < sc->num_sg && num_pages < sc->max_pages) {
+			uaddr = udata + (length - len_rem);
+			num_pages_reqd = ((uaddr + len_rem - 1)>>PAGE_SHIFT) - (uaddr>>PAGE_SHIFT) + 1;
+			num_pages_reqd = (num_pages_reqd > sc->num_sg ? sc->num_sg : num_pages_reqd);
+			if (num_pages_reqd > sc->max_pages - num_pages)
+				num_pages_reqd = sc->max_pages - num_pages;
+
+			down_read(&current->mm->mmap_sem);
+			pinned = get_user_pages(current, current->mm, uaddr, num_pages_reqd, 1, 0, &pages[num_pages], NULL);
+			up_read(&current->mm->mmap_sem);
+			if (pinned <= 0)
+				break;
 
-		// Page in the user pages.
-		down_read(&current->mm->mmap_sem);
-		num_pages = get_user_pages(current, current->mm, udata, num_pages_reqd, 1, 0, pages, NULL);
-		up_read(&current->mm->mmap_sem);
+			// Set the scatterlist values
+			for (i = num_pages; i < num_pages + pinned; ++i) {
+				len = ((fp_offset + len_rem) > PAGE_SIZE ? (PAGE_SIZE - fp_offset) : len_rem);
+				if (num_ents > 0 && fp_offset == 0 && 
+					page_to_pfn(pages[i]) == page_to_pfn(pages[i-1]) + 1 &&
+					sgl[num_ents-1].length + len <= max_elem_len) {
+					sgl[num_ents-1].length += len;
+				}
+				else {
+					if (num_ents == sc->num_sg)
+						break;
+					sg_set_page(&sgl[num_ents], pages[i], len, fp_offset);
+					num_ents++;
+				}
+				len_rem -= len;
+				fp_offset = 0;
+			}
+
+			// Release the pages that did not fit.
+			for (j = i; j < num_pages + pinned; ++j)
+				page_cache_release(pages[j]);
+			if (i < num_pages + pinned) {
+				num_pages = i;
+				break;
+			}
+			num_pages = i;
+		}
 		if (num_pages <= 0) {
 			printk(KERN_ERR "riffa: fpga:%d chnl:%d, %s unable to pin any pages in memory\n", sc->id, chnl, dir);
-			kfree(pages);
-			kfree(sg_map);
-			return NULL;
-		}
-
-		// Create the scatterlist array.
-		if ((sgl = kcalloc(num_pages, sizeof(*sgl), GFP_KERNEL)) == NULL) {
-			printk(KERN_ERR "riffa: fpga:%d chnl:%d, %s could not allocate memory for scatterlist array\n", sc->id, chnl, dir);
-			for (i = 0; i < num_pages; ++i)
-				page_cache_release(pages[i]);
-			kfree(pages);
-			kfree(sg_map);
+			release_sg_map(sg_map);
 			return NULL;
 		}
-
-		// Set the scatterlist values
-		fp_offset = (udata & (~PAGE_MASK));
-		sg_init_table(sgl, num_pages);
-		for (i = 0; i < num_pages; ++i) {
-			len = ((fp_offset + len_rem) > PAGE_SIZE ? (PAGE_SIZE - fp_offset) : len_rem);
-			sg_set_page(&sgl[i], pages[i], len, fp_offset);
-			len_rem -= len;
-			fp_offset = 0;
-		}
+		sg_mark_end(&sgl[num_ents-1]);
 
 		// Map the scatterlist values and write to the common buffer area
-		num_sg = dma_map_sg(&sc->dev->dev, sgl, num_pages, direction);
+		num_sg = dma_map_sg(&sc->dev->dev, sgl, num_ents, direction);
 		for_each_sg(sgl, sg, num_sg, i) {
 			hw_addr = sg_dma_address(sg);
 			hw_len = sg_dma_len(sg);
@@ -408,11 +581,10 @@ static inline struct sg_mapping * fill_sg_buf(struct fpga_state * sc, int chnl,
 	// Populate the number of bytes mapped and other sg data
 	sg_map->direction = direction;
 	sg_map->num_pages = num_pages;
+	sg_map->num_ents = num_ents;
 	sg_map->num_sg = num_sg;
 	sg_map->length = (length - len_rem);
 	sg_map->overflow = (overflow - overflow_rem);
-	sg_map->pages = pages;
-	sg_map->sgl = sgl;
 
 	return sg_map;
 }
@@ -428,11 +600,11 @@ static inline void free_sg_buf(struct fpga_state * sc, struct sg_mapping * sg_ma
 		return;
 
 	// Unmap the pages.
-	if (sg_map->sgl != NULL)
-		dma_unmap_sg(&sc->dev->dev, sg_map->sgl, sg_map->num_pages, sg_map->direction);
+	if (sg_map->num_pages > 0)
+		dma_unmap_sg(&sc->dev->dev, sg_map->sgl, sg_map->num_ents, sg_map->direction);
 
 	// Free the pages (mark dirty if necessary).
-	if (sg_map->pages != NULL) {
+	if (sg_map->num_pages > 0) {
 		if (sg_map->direction == DMA_FROM_DEVICE) {
 			for (i = 0; i < sg_map->num_pages; ++i) {
 				if (!PageReserved(sg_map->pages[i]))
@@ -447,12 +619,8 @@ static inline void free_sg_buf(struct fpga_state * sc, struct sg_mapping * sg_ma
 		}
 	}
 
-	// Free the structures.
-	if (sg_map->pages != NULL)
-		kfree(sg_map->pages);
-	if (sg_map->sgl != NULL)
-		kfree(sg_map->sgl);
-	kfree(sg_map);
+	// Return the structures to the pool.
+	release_sg_map(sg_map);
 }
 
 /**
@@ -535,6 +703,8 @@ static inline unsigned int chnl_recv(struct fpga_state * sc, int chnl,
 			break;
 
 		case EVENT_TXN_LEN:
+			// No longer pending for poll/eventfd listeners.
+			atomic_dec_if_positive(&sc->recv[chnl]->txns);
 			// Read the length
 			length = (((unsigned long long)msg)<<2);
 			recvd = 0;
@@ -561,8 +731,10 @@ static inline unsigned int chnl_recv(struct fpga_state * sc, int chnl,
 			if (length > 0 || overflow > 0) {
 				udata = udata + offset;
 				sg_map = fill_sg_buf(sc, chnl, sc->recv[chnl]->buf_addr, udata, length, overflow, DMA_FROM_DEVICE);
-				if (sg_map == NULL || sg_map->num_sg == 0)
+				if (sg_map == NULL || sg_map->num_sg == 0) {
+					free_sg_buf(sc, sg_map);
 					return (unsigned int)(recvd>>2);
+				}
 				// Update based on the sg_mapping
 				udata += sg_map->length;
 				length -= sg_map->length;
@@ -589,6 +761,7 @@ static inline unsigned int chnl_recv(struct fpga_state * sc, int chnl,
 			if (length > 0 || overflow > 0) {
 				sg_map = fill_sg_buf(sc, chnl, sc->recv[chnl]->buf_addr, udata, length, overflow, DMA_FROM_DEVICE);
 				if (sg_map == NULL || sg_map->num_sg == 0) {
+					free_sg_buf(sc, sg_map);
 					free_sg_buf(sc, sc->recv[chnl]->sg_map_0);
 					free_sg_buf(sc, sc->recv[chnl]->sg_map_1);
 					return (unsigned int)(recvd>>2);
@@ -693,8 +866,10 @@ static inline unsigned int chnl_send(struct fpga_state * sc, int chnl,
 
 	// Use the send common buffer to share the scatter gather data
 	sg_map = fill_sg_buf(sc, chnl, sc->send[chnl]->buf_addr, udata, length, 0, DMA_TO_DEVICE);
-	if (sg_map == NULL || sg_map->num_sg == 0)
+	if (sg_map == NULL || sg_map->num_sg == 0) {
+		free_sg_buf(sc, sg_map);
 		return (unsigned int)(sent>>2);
+	}
 
 	// Update based on the sg_mapping
 	udata += sg_map->length;
@@ -743,6 +918,7 @@ static inline unsigned int chnl_send(struct fpga_state * sc, int chnl,
 			if (length > 0) {
 				sg_map = fill_sg_buf(sc, chnl, sc->send[chnl]->buf_addr, udata, length, 0, DMA_TO_DEVICE);
 				if (sg_map == NULL || sg_map->num_sg == 0) {
+					free_sg_buf(sc, sg_map);
 					free_sg_buf(sc, sc->send[chnl]->sg_map_0);
 					free_sg_buf(sc, sc->send[chnl]->sg_map_1);
 					return (unsigned int)(sent>>2);
@@ -834,6 +1010,7 @@ static inline void reset(int id)
 		for (i = 0; i < sc->num_chnls; ++i) {
 			while (!pop_circ_queue(sc->send[i]->msgs, &dummy0, &dummy1));
 			while (!pop_circ_queue(sc->recv[i]->msgs, &dummy0, &dummy1));
+			atomic_set(&sc->recv[i]->txns, 0);
 			wake_up(&sc->send[i]->waitq);
 			wake_up(&sc->recv[i]->waitq);
 		}
@@ -842,6 +1019,107 @@ static inline void reset(int id)
 	}
 }
 
+/**
+ * Registers the eventfd descriptor fd with the recv direction of the specified
+ * channel on behalf of the file filp, which drops it when closed. The eventfd
+ * is signaled each time the FPGA starts a new transaction on the channel. A 
+ * negative fd unregisters any previous eventfd. On success, returns 0. On 
+ * error, returns a negative value.
+ */
+static inline int set_eventfd(struct fpga_state * sc, int chnl, int fd, 
+	struct file * filp)
+{
+	struct eventfd_ctx * evt = NULL;
+	struct eventfd_ctx * old;
+	unsigned long flags;
+	int pending;
+
+	if (chnl >= sc->num_chnls || chnl < 0) {
+		printk(KERN_INFO "riffa: fpga:%d chnl:%d, eventfd channel invalid!\n", sc->id, chnl);
+		return -EINVAL;
+	}
+	if (fd >= 0) {
+		evt = eventfd_ctx_fdget(fd);
+		if (IS_ERR(evt))
+			return PTR_ERR(evt);
+	}
+
+	spin_lock_irqsave(&sc->recv[chnl]->evt_lock, flags);
+	old = sc->recv[chnl]->evt;
+	sc->recv[chnl]->evt = evt;
+	sc->recv[chnl]->evt_filp = (evt != NULL ? filp : NULL);
+	// Report transactions that arrived before registration. Later ones are
+	// signaled by the interrupt handler, which counts them under this lock.
+	pending = atomic_read(&sc->recv[chnl]->txns);
+	if (evt != NULL && pending > 0)
+		eventfd_signal(evt, pending);
+	spin_unlock_irqrestore(&sc->recv[chnl]->evt_lock, flags);
+
+	if (old != NULL)
+		eventfd_ctx_put(old);
+
+	return 0;
+}
+
+/**
+ * Returns POLLIN when the channel bound to the file (see IOCTL_POLL_BIND) has
+ * a pending recv transaction. A subsequent fpga_recv on that channel will not 
+ * block waiting for the transaction to start. Unbound files report POLLERR.
+ */
+static unsigned int fpga_poll(struct file *filp, poll_table *wait)
+{
+	struct file_binding * bind;
+	struct fpga_state * sc;
+
+	bind = (struct file_binding *)filp->private_data;
+	if (bind == NULL || !atomic_read(&used_fpgas[bind->id]))
+		return POLLERR;
+	sc = fpgas[bind->id];
+	if (bind->chnl >= sc->num_chnls)
+		return POLLERR;
+
+	poll_wait(filp, &sc->recv[bind->chnl]->waitq, wait);
+	if (atomic_read(&sc->recv[bind->chnl]->txns) > 0)
+		return (POLLIN | POLLRDNORM);
+
+	return 0;
+}
+
+/**
+ * Frees the channel binding (if any) and unregisters the eventfds registered
+ * through the file (see IOCTL_SET_EVENTFD) when the file is closed.
+ */
+static int fpga_release(struct inode *inode, struct file *filp)
+{
+	struct fpga_state * sc;
+	struct eventfd_ctx * evt;
+	unsigned long flags;
+	int i;
+	int j;
+
+	for (i = 0; i < NUM_FPGAS; ++i) {
+		if (!atomic_read(&used_fpgas[i]))
+			continue;
+		sc = fpgas[i];
+		for (j = 0; j < sc->num_chnls; ++j) {
+			evt = NULL;
+			spin_lock_irqsave(&sc->recv[j]->evt_lock, flags);
+			if (sc->recv[j]->evt_filp == filp) {
+				evt = sc->recv[j]->evt;
+				sc->recv[j]->evt = NULL;
+				sc->recv[j]->evt_filp = NULL;
+			}
+			spin_unlock_irqrestore(&sc->recv[j]->evt_lock, flags);
+			if (evt != NULL)
+				eventfd_ctx_put(evt);
+		}
+	}
+
+	kfree(filp->private_data);
+	filp->private_data = NULL;
+	return 0;
+}
+
 /**
  * Main entry point for reading and writing on the device. Return value depends 
  * on ioctlnum and expected behavior. See code for details.
@@ -852,6 +1130,8 @@ static long fpga_ioctl(struct file *filp, unsigned int ioctlnum,
 	int rc;
 	fpga_chnl_io io;
 	fpga_info_list list;
+	fpga_chnl_evt evt;
+	struct file_binding * bind;
 
 	switch (ioctlnum) {
 		case IOCTL_SEND:
@@ -879,6 +1159,32 @@ static long fpga_ioctl(struct file *filp, unsigned int ioctlnum,
 		case IOCTL_RESET:
 			reset((int)ioctlparam);
 			break;
+		case IOCTL_POLL_BIND:
+			if ((rc = copy_from_user(&evt, (void *)ioctlparam, sizeof(fpga_chnl_evt)))) {
+				printk(KERN_ERR "riffa: cannot read ioctl user parameter.\n");
+				return rc;
+			}
+			if (evt.id < 0 || evt.id >= NUM_FPGAS || !atomic_read(&used_fpgas[evt.id]))
+				return -ENODEV;
+			if (evt.chnl < 0 || evt.chnl >= fpgas[evt.id]->num_chnls)
+				return -EINVAL;
+			if (filp->private_data == NULL) {
+				if ((bind = kmalloc(sizeof(*bind), GFP_KERNEL)) == NULL)
+					return -ENOMEM;
+				filp->private_data = bind;
+			}
+			bind = (struct file_binding *)filp->private_data;
+			bind->id = evt.id;
+			bind->chnl = evt.chnl;
+			break;
+		case IOCTL_SET_EVENTFD:
+			if ((rc = copy_from_user(&evt, (void *)ioctlparam, sizeof(fpga_chnl_evt)))) {
+				printk(KERN_ERR "riffa: cannot read ioctl user parameter.\n");
+				return rc;
+			}
+			if (evt.id < 0 || evt.id >= NUM_FPGAS || !atomic_read(&used_fpgas[evt.id]))
+				return -ENODEV;
+			return set_eventfd(fpgas[evt.id], evt.chnl, evt.fd, filp);
 		default:
 			break;
 	}
@@ -905,6 +1211,8 @@ static inline int __devinit allocate_chnls(struct pci_dev *dev, struct fpga_stat
 		if (sc->recv[i] == NULL)
 			return i;
 		init_waitqueue_head(&sc->recv[i]->waitq);
+		atomic_set(&sc->recv[i]->txns, 0);
+		spin_lock_init(&sc->recv[i]->evt_lock);
 		if ((sc->recv[i]->msgs = init_circ_queue(5)) == NULL) {
 			kfree(sc->recv[i]);
 			return i;
@@ -946,6 +1254,21 @@ static inline int __devinit allocate_chnls(struct pci_dev *dev, struct fpga_stat
 			kfree(sc->recv[i]);
 			return i;
 		}
+
+		// Preallocate the sg_mapping pools
+		if (init_sg_pool(sc, sc->recv[i]) || init_sg_pool(sc, sc->send[i])) {
+			free_sg_pool(sc->send[i]);
+			free_sg_pool(sc->recv[i]);
+			pci_free_consistent(dev, sc->sg_buf_size, sc->send[i]->buf_addr, 
+				(dma_addr_t)sc->send[i]->buf_hw_addr);
+			free_circ_queue(sc->send[i]->msgs);
+			kfree(sc->send[i]);
+			pci_free_consistent(dev, sc->sg_buf_size, sc->recv[i]->buf_addr, 
+				(dma_addr_t)sc->recv[i]->buf_hw_addr);
+			free_circ_queue(sc->recv[i]->msgs);
+			kfree(sc->recv[i]);
+			return i;
+		}
 	}
 
 	return i;
@@ -986,6 +1309,9 @@ static int __devinit fpga_probe(struct pci_dev *dev, const struct pci_device_id
 		return error;
 	}
 
+	// Let SG elements span physically contiguous (e.g. huge) pages
+	dma_set_max_seg_size(&dev->dev, SG_MAX_ELEM_LEN);
+
 	// Allocate device structure.
 	sc = kzalloc(sizeof(*sc), GFP_KERNEL);
 	if (sc == NULL) {
@@ -1112,8 +1438,11 @@ static int __devinit fpga_probe(struct pci_dev *dev, const struct pci_device_id
 	// Read device configuration
 	reg = read_reg(sc, INFO_REG_OFF);
 	sc->num_chnls = ((reg>>0) & 0xF);
-	sc->num_sg = SG_ELEMS*((reg>>19) & 0xF);
+	sc->num_sg = (sg_elems > 0 ? sg_elems : SG_ELEMS)*((reg>>19) & 0xF);
 	sc->sg_buf_size = SG_BUF_SIZE*((reg>>19) & 0xF);
+	if (sc->sg_buf_size < sc->num_sg*4*sizeof(unsigned int))
+		sc->sg_buf_size = PAGE_ALIGN(sc->num_sg*4*sizeof(unsigned int));
+	sc->max_pages = (sg_max_pages > sc->num_sg ? sg_max_pages : sc->num_sg);
     printk(KERN_INFO "riffa: number of channels: %d\n", ((reg>>0) & 0xF));
     printk(KERN_INFO "riffa: bus interface width: %d\n", ((reg>>19) & 0xF)<<5);
     printk(KERN_INFO "riffa: bus master enabled: %d\n", ((reg>>4) & 0x1));
@@ -1204,6 +1533,8 @@ static int __devinit fpga_probe(struct pci_dev *dev, const struct pci_device_id
 				(dma_addr_t)sc->recv[i]->buf_hw_addr);
 			free_circ_queue(sc->send[i]->msgs);
 			free_circ_queue(sc->recv[i]->msgs);
+			free_sg_pool(sc->send[i]);
+			free_sg_pool(sc->recv[i]);
 			kfree(sc->send[i]);
 			kfree(sc->recv[i]);
 		}
@@ -1232,6 +1563,8 @@ static int __devinit fpga_probe(struct pci_dev *dev, const struct pci_device_id
 				(dma_addr_t)sc->recv[i]->buf_hw_addr);
 			free_circ_queue(sc->send[i]->msgs);
 			free_circ_queue(sc->recv[i]->msgs);
+			free_sg_pool(sc->send[i]);
+			free_sg_pool(sc->recv[i]);
 			kfree(sc->send[i]);
 			kfree(sc->recv[i]);
 		}
@@ -1267,6 +1600,8 @@ static int __devinit fpga_probe(struct pci_dev *dev, const struct pci_device_id
 				(dma_addr_t)sc->recv[i]->buf_hw_addr);
 			free_circ_queue(sc->send[i]->msgs);
 			free_circ_queue(sc->recv[i]->msgs);
+			free_sg_pool(sc->send[i]);
+			free_sg_pool(sc->recv[i]);
 			kfree(sc->send[i]);
 			kfree(sc->recv[i]);
 		}
@@ -1288,6 +1623,15 @@ static int __devinit fpga_probe(struct pci_dev *dev, const struct pci_device_id
 		printk(KERN_INFO "riffa: saved FPGA with id: %d\n", sc->id);
 	}
 
+	// Expose the sg_mapping allocation counters.
+	atomic_set(&sc->sg_pool_hits, 0);
+	atomic_set(&sc->sg_allocs, 0);
+	if (debugfs_dir != NULL) {
+		char name[24];
+		snprintf(name, sizeof(name), "fpga%d_sg_pool", sc->id);
+		sc->debugfs_file = debugfs_create_file(name, 0444, debugfs_dir, sc, &sg_pool_fops);
+	}
+
 	return 0;
 }
 
@@ -1309,13 +1653,18 @@ static void __devexit fpga_remove(struct pci_dev *dev)
 	if ((sc = (struct fpga_state *)pci_get_drvdata(dev)) != NULL) {
 		// Free structs, memory regions, etc.
 		atomic_set(&used_fpgas[sc->id], 0);
+		debugfs_remove(sc->debugfs_file);
 		for (i = 0; i < sc->num_chnls; ++i) {
+			if (sc->recv[i]->evt != NULL)
+				eventfd_ctx_put(sc->recv[i]->evt);
 			pci_free_consistent(dev, sc->sg_buf_size, sc->send[i]->buf_addr, 
 				(dma_addr_t)sc->send[i]->buf_hw_addr);
 			pci_free_consistent(dev, sc->sg_buf_size, sc->recv[i]->buf_addr, 
 				(dma_addr_t)sc->recv[i]->buf_hw_addr);
 			free_circ_queue(sc->send[i]->msgs);
 			free_circ_queue(sc->recv[i]->msgs);
+			free_sg_pool(sc->send[i]);
+			free_sg_pool(sc->recv[i]);
 			kfree(sc->send[i]);
 			kfree(sc->recv[i]);
 		}
@@ -1355,6 +1704,8 @@ static struct pci_driver fpga_driver = {
 static const struct file_operations fpga_fops = {
 	.owner			= THIS_MODULE,
 	.unlocked_ioctl	= fpga_ioctl,
+	.poll			= fpga_poll,
+	.release		= fpga_release,
 };
 
 /**
@@ -1368,6 +1719,11 @@ static int __init fpga_init(void)
 	for (i = 0; i < NUM_FPGAS; i++)
 		atomic_set(&used_fpgas[i], 0);
 
+	// The debugfs entries are optional, ignore failures.
+	debugfs_dir = debugfs_create_dir(DEVICE_NAME, NULL);
+	if (IS_ERR(debugfs_dir))
+		debugfs_dir = NULL;
+
 	error = pci_register_driver(&fpga_driver);
 	if (error != 0) {
 		printk(KERN_ERR "riffa: pci_module_register returned %d\n", error);
@@ -1402,6 +1758,7 @@ static void __exit fpga_exit(void)
 	class_destroy(mymodule_class);
 	pci_unregister_driver(&fpga_driver);
 	unregister_chrdev(MAJOR_NUM, DEVICE_NAME);
+	debugfs_remove_recursive(debugfs_dir);
 }
 
 module_init(fpga_init);
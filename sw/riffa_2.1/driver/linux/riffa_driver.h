@@ -80,8 +80,8 @@
 #define NUM_FPGAS					5 	// max # of FPGAs to support in a single PC
 #define MAX_CHNLS					12	// max # of channels per FPGA
 #define MAX_BUS_WIDTH_PARAM			4	// max bus width parameter
-#define SG_BUF_SIZE					(4*1024)	// size of shared SG buffer
-#define SG_ELEMS					200 // # of SG elements to transfer at a time
+#define SG_BUF_SIZE					(4*1024)	// min size of shared SG buffer
+#define SG_ELEMS					200 // default # of SG elements to transfer at a time (sg_elems module param)
 #define SPILL_BUF_SIZE				(4*1024)	// size of shared spill common buffer
 
 #define RX_SG_LEN_REG_OFF			0x0	// config offset for RX SG buf length
@@ -127,11 +127,21 @@ struct fpga_info_list
 };
 typedef struct fpga_info_list fpga_info_list;
 
+struct fpga_chnl_evt
+{
+	int id;
+	int chnl;
+	int fd;
+};
+typedef struct fpga_chnl_evt fpga_chnl_evt;
+
 // IOCTLs
 #define IOCTL_SEND _IOW(MAJOR_NUM, 1, fpga_chnl_io *)
 #define IOCTL_RECV _IOR(MAJOR_NUM, 2, fpga_chnl_io *)
 #define IOCTL_LIST _IOR(MAJOR_NUM, 3, fpga_info_list *)
 #define IOCTL_RESET _IOW(MAJOR_NUM, 4, int)
+#define IOCTL_POLL_BIND _IOW(MAJOR_NUM, 5, fpga_chnl_evt *)
+#define IOCTL_SET_EVENTFD _IOW(MAJOR_NUM, 6, fpga_chnl_evt *)
 
 
 